@@ -0,0 +1,141 @@
+// Microbenchmark: mensajes/segundo entre los PEs y el árbitro con el camino anterior del bus
+// (std::queue acotada protegida por bus_mutex y bus_cv, con la línea completa embebida en cada
+// mensaje de 56 bytes) y con el actual (MpscRing sin locks y encabezado de 8 bytes). Hoy ningún
+// mensaje lleva datos: la víctima sucia se escribe en memoria dentro de la transacción que la desalojó
+// (Interconnect::write_back_victim), así que en el camino actual el productor la copia a su propio
+// buffer y por la cola solo pasa el encabezado.
+//
+// Uso: bench_bus_message [productores=4] [mensajes_por_productor=1000000] [capacidad_cola=16]
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "../Interconnect/bus_types.h"
+#include "../Interconnect/mpsc_ring.h"
+
+using namespace std;
+
+namespace {
+
+// Formato anterior: siempre 56 bytes, con datos aunque el mensaje no los use
+struct LegacyBusMessage {
+    int sender_id;
+    MessageType type;
+    size_t address;
+    double data;
+    array<double, 4> cache_line;
+};
+
+// Cola anterior del interconnect: el PE espera espacio y el árbitro espera mensajes en la misma
+// condición, todo bajo el mutex del bus
+class LegacyBusQueue {
+public:
+    explicit LegacyBusQueue(size_t depth) : depth_(depth) {}
+
+    void push(const LegacyBusMessage& msg) {
+        unique_lock<mutex> lock(bus_mutex_);
+        bus_cv_.wait(lock, [&] { return bus_queue_.size() < depth_; });
+        bus_queue_.push(msg);
+        bus_cv_.notify_all();
+    }
+
+    void pop_wait(LegacyBusMessage& msg) {
+        unique_lock<mutex> lock(bus_mutex_);
+        bus_cv_.wait(lock, [&] { return !bus_queue_.empty(); });
+        msg = bus_queue_.front();
+        bus_queue_.pop();
+        bus_cv_.notify_all();
+    }
+
+private:
+    size_t depth_;
+    mutex bus_mutex_;
+    condition_variable bus_cv_;
+    queue<LegacyBusMessage> bus_queue_;
+};
+
+// Mezcla típica: 1 de cada 4 mensajes es WRITE_BACK con datos
+MessageType type_for(size_t i) {
+    switch (i & 3) {
+        case 0: return READ_MISS;
+        case 1: return WRITE_MISS;
+        case 2: return INVALIDATE;
+        default: return WRITE_BACK;
+    }
+}
+
+template <typename Produce, typename Consume>
+double run(int producers, size_t per_producer, Produce produce, Consume consume) {
+    auto start = chrono::steady_clock::now();
+
+    vector<thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (size_t i = 0; i < per_producer; ++i) produce(p, i);
+        });
+    }
+
+    size_t total = static_cast<size_t>(producers) * per_producer;
+    for (size_t received = 0; received < total; ++received) consume();
+
+    for (auto& t : threads) t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return total / seconds;
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    int producers = argc > 1 ? atoi(argv[1]) : 4;
+    size_t per_producer = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000;
+    size_t depth = argc > 3 ? strtoull(argv[3], nullptr, 10) : 16;
+
+    volatile double sink = 0.0;                                                         // Evita que el consumo se optimice
+
+    // ------------------------------------------------------------------ std::queue + bus_mutex
+    LegacyBusQueue legacy_queue(depth);
+    double legacy_rate = run(producers, per_producer,
+        [&](int p, size_t i) {
+            LegacyBusMessage msg{};
+            msg.sender_id = p;
+            msg.type = type_for(i);
+            msg.address = i & 0xFFFF;
+            if (msg.type == WRITE_BACK) msg.cache_line = {double(i), 1.0, 2.0, 3.0};
+            legacy_queue.push(msg);
+        },
+        [&] {
+            LegacyBusMessage msg{};
+            legacy_queue.pop_wait(msg);
+            if (msg.type == WRITE_BACK) sink = sink + msg.cache_line[0];
+        });
+
+    // ------------------------------------------------------------------ MpscRing + encabezado
+    MpscRing<BusMessage> ring(depth);
+    vector<array<double, 4>> victims(producers);                                        // Memoria de cada productor
+    double compact_rate = run(producers, per_producer,
+        [&](int p, size_t i) {
+            BusMessage msg;
+            msg.sender_id = static_cast<int16_t>(p);
+            msg.type = type_for(i);
+            msg.address = static_cast<uint32_t>(i & 0xFFFF);
+            if (msg.type == WRITE_BACK) victims[p] = {double(i), 1.0, 2.0, 3.0};
+            ring.push(msg);
+        },
+        [&] {
+            BusMessage msg;
+            ring.pop_wait(msg);
+            if (msg.type == WRITE_BACK) sink = sink + msg.address;
+        });
+
+    cout << "path,message_bytes,messages_per_second\n";
+    cout << "queue_mutex," << sizeof(LegacyBusMessage) << "," << legacy_rate << "\n";
+    cout << "ring_header," << sizeof(BusMessage) << "," << compact_rate << "\n";
+    return 0;
+}
@@ -0,0 +1,136 @@
+// Suite de benchmarks de coherencia: cada patrón sintético (Workload/synthetic.h) se reproduce con
+// 2..64 PEs sobre el protocolo elegido y se mide el rendimiento del propio simulador.
+//
+// Uso: bench_coherence [resultados.csv] [ops_por_pe=2000] [protocolo=MESI|MOESI|MESIF|all]
+//                      [lista_pes=2,4,8,16,32,64] [write_ratio=0.1] [motor=threads|event] [bancos=1]
+//                      [mshrs=1] [bus=atomic|split|all]
+//
+// Motor threads: un hilo por PE (TraceReplayer). Motor event: un solo hilo (Sim/event_engine.h),
+// determinista, que además reporta los ciclos simulados. Con mshrs > 1 los PEs no esperan sus misses
+// (read_async/write_async en threads, misses solapados en event).
+// bus elige el modelo del bus en el motor threads (event siempre usa INLINE). Con bus=all la misma
+// carga corre con el bus ATOMIC y con el SPLIT, en filas consecutivas: comparar bus_tx_per_second.
+//
+// Columnas: pattern,protocol,engine,bus,pes,ops,seconds,ops_per_second,bus_tx_per_op,messages_per_op,
+//           miss_ratio,sim_cycles,mshrs,bus_tx_per_second
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../Sim/event_engine.h"
+#include "../Sim/sim_system.h"
+#include "../Workload/synthetic.h"
+#include "../Workload/trace_replayer.h"
+
+using namespace std;
+
+namespace {
+
+vector<int> parse_pe_list(const string& text) {
+    vector<int> out;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        int n = atoi(item.c_str());
+        if (n > 0) out.push_back(n);
+    }
+    return out;
+}
+
+vector<ProtocolKind> parse_protocols(const string& text) {
+    if (text == "all") return {ProtocolKind::MESI, ProtocolKind::MOESI, ProtocolKind::MESIF};
+    if (text == "MOESI") return {ProtocolKind::MOESI};
+    if (text == "MESIF") return {ProtocolKind::MESIF};
+    return {ProtocolKind::MESI};
+}
+
+vector<BusMode> parse_bus_modes(const string& text) {
+    if (text == "all") return {BusMode::ATOMIC, BusMode::SPLIT};
+    if (text == "split") return {BusMode::SPLIT};
+    return {BusMode::ATOMIC};
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    string results_path = argc > 1 ? argv[1] : "bench_coherence.csv";
+    size_t ops_per_pe = argc > 2 ? strtoull(argv[2], nullptr, 10) : 2000;
+    vector<ProtocolKind> protocols = parse_protocols(argc > 3 ? argv[3] : "MESI");
+    vector<int> pe_counts = parse_pe_list(argc > 4 ? argv[4] : "2,4,8,16,32,64");
+    double write_ratio = argc > 5 ? atof(argv[5]) : 0.1;
+    bool event_engine = argc > 6 && string(argv[6]) == "event";
+    size_t num_banks = argc > 7 ? strtoull(argv[7], nullptr, 10) : 1;
+    size_t mshrs = argc > 8 ? strtoull(argv[8], nullptr, 10) : 1;
+    vector<BusMode> bus_modes = event_engine ? vector<BusMode>{BusMode::INLINE} : parse_bus_modes(argc > 9 ? argv[9] : "atomic");
+
+    ofstream results(results_path);
+    if (!results) {
+        cerr << "[Bench] No se pudo abrir " << results_path << endl;
+        return 1;
+    }
+
+    const char* header = "pattern,protocol,engine,bus,pes,ops,seconds,ops_per_second,bus_tx_per_op,messages_per_op,"
+                         "miss_ratio,sim_cycles,mshrs,bus_tx_per_second\n";
+    results << header;
+    cout << header;
+
+    for (size_t p = 0; p < NUM_SYNTHETIC_PATTERNS; ++p) {
+        for (ProtocolKind protocol : protocols) {
+            for (int pes : pe_counts) {
+                SyntheticConfig workload;
+                workload.pattern = static_cast<SyntheticPattern>(p);
+                workload.num_pes = pes;
+                workload.ops_per_pe = ops_per_pe;
+                workload.write_ratio = write_ratio;
+
+                WorkloadTrace trace;
+                if (!make_synthetic_trace(workload, trace)) return 1;
+
+                for (BusMode bus_mode : bus_modes) {
+                    SimConfig config;
+                    config.num_pes = pes;
+                    config.protocol = protocol;
+                    config.bus_mode = bus_mode;
+                    config.num_banks = num_banks;
+                    config.mshrs_per_pe = mshrs;
+                    SimSystem system(config);
+
+                    uint64_t operations = 0;
+                    uint64_t sim_cycles = 0;
+                    double seconds = 0.0;
+                    if (event_engine) {
+                        EventEngine engine(system);
+                        EventSimResult run = engine.run(trace);
+                        operations = run.operations;
+                        seconds = run.seconds;
+                        sim_cycles = run.cycles;
+                    } else {
+                        TraceReplayer replayer(trace, system.controllers(), mshrs > 1);
+                        ReplayResult run = replayer.run();
+                        operations = run.operations;
+                        seconds = run.seconds;
+                    }
+                    SimTotals totals = system.totals();
+
+                    double ops = static_cast<double>(operations);
+                    ostringstream row;
+                    row << synthetic_pattern_name(workload.pattern) << "," << protocol_kind_name(protocol)
+                        << "," << (event_engine ? "event" : "threads") << "," << bus_mode_name(bus_mode) << "," << pes
+                        << "," << operations << "," << seconds << "," << (seconds > 0.0 ? ops / seconds : 0.0)
+                        << "," << (ops ? system.interconnect().get_completed_transactions() / ops : 0.0)
+                        << "," << (ops ? totals.messages / ops : 0.0)
+                        << "," << totals.miss_ratio() << "," << sim_cycles << "," << mshrs
+                        << "," << system.interconnect().get_transactions_per_second() << "\n";
+                    results << row.str();
+                    cout << row.str() << flush;
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,254 @@
+// Locks sobre las operaciones atómicas de MESIController: cada PE toma y suelta el lock acquires veces
+// (sección crítica: leer y escribir un contador compartido) y se mide el costo de coherencia de cada
+// adquisición al crecer la cantidad de PEs.
+//
+// Uso: bench_locks [resultados.csv] [acquires_por_pe=200] [lista_pes=2,4,8,16] [protocolo=MESI|MOESI|MESIF]
+//
+// Locks: tas (exchange en cada intento), ttas (espera leyendo y luego exchange), llsc (load_linked /
+// store_conditional), ticket (fetch_add del número y espera leyendo el turno) y queue (cola de Anderson:
+// cada PE espera sobre su propia línea y el que suelta avisa solo al siguiente).
+//
+// Un solo hilo y bus INLINE, como el motor event (Sim/event_engine.h): cada PE es una máquina de
+// estados que hace una operación de memoria por evento, y la latencia de cada operación sale del mismo
+// LatencyModel (un banco). La espera activa cuesta un ciclo por lectura que acierta, así que los
+// resultados no dependen de cuántos núcleos tiene el equipo. Latencias en ciclos, desde que el PE pide
+// el lock hasta que lo obtiene. ok = 1 si el contador final es pes * acquires (exclusión mutua).
+//
+// Columnas: lock,protocol,pes,acquires,sim_cycles,bus_tx_per_acquire,messages_per_acquire,
+//           invalidations_per_acquire,atomics_per_acquire,acquire_mean_cycles,acquire_p99_cycles,ok
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../Sim/event_engine.h"
+#include "../Sim/sim_system.h"
+#include "../Stats/sim_stats.h"
+
+using namespace std;
+
+namespace {
+
+enum class LockKind {
+    TAS,
+    TTAS,
+    LLSC,
+    TICKET,
+    QUEUE,
+};
+
+const char* lock_kind_name(LockKind kind) {
+    switch (kind) {
+        case LockKind::TAS: return "tas";
+        case LockKind::TTAS: return "ttas";
+        case LockKind::LLSC: return "llsc";
+        case LockKind::TICKET: return "ticket";
+        case LockKind::QUEUE: return "queue";
+    }
+    return "unknown";
+}
+
+// Cada variable en su propia línea
+constexpr uint16_t kLock = 0;                                                           // tas/ttas/llsc; ticket y queue: próximo número
+constexpr uint16_t kServing = WORDS_PER_LINE;                                           // ticket: turno actual
+constexpr uint16_t kFlags = 2 * WORDS_PER_LINE;                                         // queue: una línea por ranura
+constexpr uint16_t kCounter = 0x8000;                                                   // Dato de la sección crítica
+
+uint16_t flag_address(uint64_t slot) {
+    return static_cast<uint16_t>(kFlags + slot * WORDS_PER_LINE);
+}
+
+enum class Phase {
+    REQUEST,                                                                            // Primera operación de la adquisición
+    SPIN,
+    TRY,                                                                                // El lock parece libre: intenta tomarlo
+    CRITICAL_READ,
+    CRITICAL_WRITE,
+    RELEASE,
+};
+
+struct Worker {
+    int pe = 0;
+    Phase phase = Phase::REQUEST;
+    size_t acquired = 0;
+    uint64_t requested_at = 0;
+    uint64_t token = 0;                                                                 // ticket: número; queue: ranura
+    double value = 0.0;                                                                 // Contador leído en la sección crítica
+};
+
+// Una operación de memoria del PE según su fase; true si con ella obtuvo el lock
+bool step(LockKind kind, size_t num_pes, Worker& w, MESIController& mesi, uint64_t now) {
+    switch (w.phase) {
+        case Phase::REQUEST:
+            w.requested_at = now;
+            if (kind == LockKind::TICKET || kind == LockKind::QUEUE) {
+                uint64_t number = static_cast<uint64_t>(mesi.fetch_add(kLock, 1.0).value_or(0.0));
+                w.token = kind == LockKind::TICKET ? number : number % num_pes;
+                w.phase = Phase::SPIN;
+                return false;
+            }
+            [[fallthrough]];
+        case Phase::SPIN:
+            switch (kind) {
+                case LockKind::TAS:
+                    w.phase = mesi.exchange(kLock, 1.0).value_or(1.0) == 0.0 ? Phase::CRITICAL_READ : Phase::SPIN;
+                    return w.phase == Phase::CRITICAL_READ;
+                case LockKind::TTAS:
+                    w.phase = mesi.read(kLock).value_or(1.0) == 0.0 ? Phase::TRY : Phase::SPIN;   // Espera en su copia S
+                    return false;
+                case LockKind::LLSC:
+                    w.phase = mesi.load_linked(kLock).value_or(1.0) == 0.0 ? Phase::TRY : Phase::SPIN;
+                    return false;
+                case LockKind::TICKET:
+                    if (static_cast<uint64_t>(mesi.read(kServing).value_or(0.0)) != w.token) return false;
+                    w.phase = Phase::CRITICAL_READ;
+                    return true;
+                case LockKind::QUEUE:
+                    if (mesi.read(flag_address(w.token)).value_or(0.0) != 0.0) w.phase = Phase::TRY;
+                    return false;
+            }
+            return false;
+        case Phase::TRY: {
+            bool taken = true;
+            if (kind == LockKind::TTAS) taken = mesi.exchange(kLock, 1.0).value_or(1.0) == 0.0;
+            else if (kind == LockKind::LLSC) taken = mesi.store_conditional(kLock, 1.0);
+            else mesi.write(flag_address(w.token), 0.0);                                // queue: la ranura queda cerrada para la próxima vuelta
+            w.phase = taken ? Phase::CRITICAL_READ : Phase::SPIN;
+            return taken;
+        }
+        case Phase::CRITICAL_READ:
+            w.value = mesi.read(kCounter).value_or(0.0);
+            w.phase = Phase::CRITICAL_WRITE;
+            return false;
+        case Phase::CRITICAL_WRITE:
+            mesi.write(kCounter, w.value + 1.0);
+            w.phase = Phase::RELEASE;
+            return false;
+        case Phase::RELEASE:
+            if (kind == LockKind::TICKET) mesi.write(kServing, static_cast<double>(w.token + 1));  // Solo el dueño escribe el turno
+            else if (kind == LockKind::QUEUE) mesi.write(flag_address((w.token + 1) % num_pes), 1.0);
+            else mesi.write(kLock, 0.0);
+            w.acquired++;
+            w.phase = Phase::REQUEST;
+            return false;
+    }
+    return false;
+}
+
+vector<int> parse_pe_list(const string& text) {
+    vector<int> out;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        int n = atoi(item.c_str());
+        if (n > 0) out.push_back(n);
+    }
+    return out;
+}
+
+ProtocolKind parse_protocol(const string& text) {
+    if (text == "MOESI") return ProtocolKind::MOESI;
+    if (text == "MESIF") return ProtocolKind::MESIF;
+    return ProtocolKind::MESI;
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    string results_path = argc > 1 ? argv[1] : "bench_locks.csv";
+    size_t acquires = argc > 2 ? strtoull(argv[2], nullptr, 10) : 200;
+    vector<int> pe_counts = parse_pe_list(argc > 3 ? argv[3] : "2,4,8,16");
+    ProtocolKind protocol = parse_protocol(argc > 4 ? argv[4] : "MESI");
+
+    ofstream results(results_path);
+    if (!results) {
+        cerr << "[Bench] No se pudo abrir " << results_path << endl;
+        return 1;
+    }
+
+    const char* header = "lock,protocol,pes,acquires,sim_cycles,bus_tx_per_acquire,messages_per_acquire,"
+                         "invalidations_per_acquire,atomics_per_acquire,acquire_mean_cycles,acquire_p99_cycles,ok\n";
+    results << header;
+    cout << header;
+
+    const LatencyModel latency;
+    for (LockKind kind : {LockKind::TAS, LockKind::TTAS, LockKind::LLSC, LockKind::TICKET, LockKind::QUEUE}) {
+        for (int pes : pe_counts) {
+            SimConfig config;
+            config.num_pes = pes;
+            config.protocol = protocol;
+            config.bus_mode = BusMode::INLINE;
+            SimSystem system(config);
+            Interconnect& interconnect = system.interconnect();
+            const MemoryStats& memory = interconnect.memory().stats();
+
+            interconnect.set_sim_time(0);                                               // La DRAM corre con el reloj simulado desde el inicio
+            if (kind == LockKind::QUEUE) system.controller(0)->write(flag_address(0), 1.0);  // La ranura 0 arranca abierta
+            interconnect.reset_stats();
+
+            vector<Worker> workers(pes);
+            EventQueue queue;
+            for (int pe = 0; pe < pes; ++pe) {
+                workers[pe].pe = pe;
+                queue.push(0, static_cast<uint32_t>(pe));
+            }
+
+            LatencyHistogram acquire_cycles;
+            uint64_t bus_free_at = 0;
+            uint64_t cycles = 0;
+            while (!queue.empty()) {
+                SimEvent event = queue.pop();
+                Worker& w = workers[event.stream];
+                PeStats& stats = interconnect.stats().pe(w.pe);
+
+                uint64_t tx_before = interconnect.get_completed_transactions();
+                uint64_t c2c_before = stats.cache_to_cache.load(memory_order_relaxed);
+                uint64_t mem_before = memory.read_latency_ns.load(memory_order_relaxed);
+                uint64_t wb_before = stats.write_backs.load(memory_order_relaxed);
+
+                uint64_t grant = max(event.time, bus_free_at);
+                interconnect.set_sim_time(grant);
+                bool acquired = step(kind, pes, w, *system.controller(w.pe), event.time);
+
+                uint64_t done = event.time + latency.hit_cycles;
+                if (uint64_t transactions = interconnect.get_completed_transactions() - tx_before) {
+                    uint64_t occupancy = transactions * latency.bus_cycles;
+                    occupancy += (stats.cache_to_cache.load(memory_order_relaxed) - c2c_before) * latency.cache_to_cache_cycles;
+                    occupancy += memory.read_latency_ns.load(memory_order_relaxed) - mem_before;
+                    occupancy += (stats.write_backs.load(memory_order_relaxed) - wb_before) * latency.write_back_cycles;
+                    bus_free_at = grant + occupancy;
+                    done = bus_free_at;
+                }
+                if (acquired) acquire_cycles.record(done - w.requested_at);
+                cycles = max(cycles, done);
+                if (w.acquired < acquires) queue.push(done, event.stream);
+            }
+
+            uint64_t transactions = interconnect.get_completed_transactions();
+            uint64_t messages = system.totals().messages;
+            uint64_t invalidations = 0;
+            uint64_t atomics = 0;
+            for (int pe = 0; pe < pes; ++pe) {
+                const PeStats& stats = interconnect.stats().pe(pe);
+                invalidations += stats.invalidations_received.load(memory_order_relaxed);
+                atomics += stats.atomic_rmws.load(memory_order_relaxed) + stats.store_conditionals.load(memory_order_relaxed);
+            }
+            bool ok = system.controller(0)->read(kCounter).value_or(0.0) == static_cast<double>(pes * acquires);
+
+            double total = static_cast<double>(pes * acquires);
+            ostringstream row;
+            row << lock_kind_name(kind) << "," << protocol_kind_name(protocol) << "," << pes << "," << acquires
+                << "," << cycles << "," << transactions / total << "," << messages / total
+                << "," << invalidations / total << "," << atomics / total
+                << "," << acquire_cycles.mean() << "," << acquire_cycles.percentile(99) << "," << (ok ? 1 : 0) << "\n";
+            results << row.str();
+            cout << row.str() << flush;
+        }
+    }
+    return 0;
+}
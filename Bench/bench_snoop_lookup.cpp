@@ -0,0 +1,131 @@
+// Rendimiento de la búsqueda de poseedores de un bloque para el snoop, con 4, 16 y 64 PEs:
+//   simd    SnoopStateStore::for_each_holder (comparación AVX2/SSE2 de la fila del bloque)
+//   scalar  la misma fila recorrida byte a byte (holder_mask_scalar)
+//   probe   la ruta anterior: consultar la caché de cada PE (Cache::read_linea_cache)
+//
+// Uso: bench_snoop_lookup [resultados.csv] [consultas=2000000] [lista_pes=4,16,64] [sharers=2]
+//
+// Columnas: pes,method,lookups,seconds,lookups_per_second,ns_per_lookup,holders_found
+// Compilar con -mavx2 para la variante AVX2; sin ella se usa SSE2 (x86-64) o la escalar.
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../cache/include/Cache.h"
+#include "../Interconnect/snoop_state_store.h"
+
+using namespace std;
+
+namespace {
+
+vector<int> parse_pe_list(const string& text) {
+    vector<int> out;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        int n = atoi(item.c_str());
+        if (n > 0) out.push_back(n);
+    }
+    return out;
+}
+
+uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Mide fn(address) sobre una secuencia fija de direcciones; devuelve segundos
+template <typename F>
+double time_lookups(const vector<uint16_t>& addresses, size_t lookups, F&& fn) {
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i) fn(addresses[i % addresses.size()]);
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    string results_path = argc > 1 ? argv[1] : "bench_snoop_lookup.csv";
+    size_t lookups = argc > 2 ? strtoull(argv[2], nullptr, 10) : 2000000;
+    vector<int> pe_counts = parse_pe_list(argc > 3 ? argv[3] : "4,16,64");
+    int sharers = argc > 4 ? atoi(argv[4]) : 2;
+
+    ofstream results(results_path);
+    if (!results) {
+        cerr << "[Bench] No se pudo abrir " << results_path << endl;
+        return 1;
+    }
+
+    const char* header = "pes,method,lookups,seconds,lookups_per_second,ns_per_lookup,holders_found\n";
+    results << header;
+    cout << "# SnoopStateStore: " << SnoopStateStore::simd_name() << "\n" << header;
+
+    for (int pes : pe_counts) {
+        uint64_t rng = 0x5EED0000ull + pes;
+        SnoopStateStore store(pes);
+        vector<unique_ptr<Cache>> caches;
+        for (int pe = 0; pe < pes; ++pe) caches.push_back(make_unique<Cache>());
+
+        // Cada bloque usado tiene hasta `sharers` poseedores al azar; las cachés guardan los más recientes
+        vector<uint16_t> addresses(4096);
+        array<double,4> linea{};
+        for (auto& address : addresses) {
+            address = static_cast<uint16_t>((splitmix64(rng) % NUM_BLOCKS) * WORDS_PER_LINE);
+            for (int s = 0; s < sharers; ++s) {
+                int pe = static_cast<int>(splitmix64(rng) % pes);
+                store.set(address, pe, LineState::SHARED);
+                caches[pe]->write_linea_cache(address, linea);
+            }
+        }
+
+        for (uint16_t address : addresses) {                                            // Las dos variantes deben coincidir
+            for (size_t first = 0; first < static_cast<size_t>(pes); first += SnoopStateStore::CHUNK_PES) {
+                if (store.holder_mask(address, first) != store.holder_mask_scalar(address, first)) {
+                    cerr << "[Bench] Máscara SIMD distinta de la escalar en dirección " << address << endl;
+                    return 1;
+                }
+            }
+        }
+
+        auto report = [&](const char* method, double seconds, uint64_t found) {
+            ostringstream row;
+            row << pes << "," << method << "," << lookups << "," << seconds
+                << "," << (seconds > 0.0 ? lookups / seconds : 0.0)
+                << "," << (lookups ? seconds * 1e9 / lookups : 0.0) << "," << found << "\n";
+            results << row.str();
+            cout << row.str() << flush;
+        };
+
+        uint64_t found = 0;
+        double seconds = time_lookups(addresses, lookups, [&](uint16_t address) {
+            store.for_each_holder(address, -1, [&](int) { found++; return false; });
+        });
+        report("simd", seconds, found);
+
+        found = 0;
+        seconds = time_lookups(addresses, lookups, [&](uint16_t address) {
+            for (size_t first = 0; first < static_cast<size_t>(pes); first += SnoopStateStore::CHUNK_PES) {
+                found += __builtin_popcountll(store.holder_mask_scalar(address, first));
+            }
+        });
+        report("scalar", seconds, found);
+
+        found = 0;
+        seconds = time_lookups(addresses, lookups, [&](uint16_t address) {
+            for (int pe = 0; pe < pes; ++pe) {
+                if (caches[pe]->read_linea_cache(address).has_value()) found++;
+            }
+        });
+        report("probe", seconds, found);
+    }
+    return 0;
+}
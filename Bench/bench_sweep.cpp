@@ -0,0 +1,105 @@
+// Barrido de parámetros: todas las combinaciones de patrón sintético, protocolo, cantidad de PEs,
+// tamaño de caché, bancos del bus y modo de coherencia, corridas como simulaciones independientes en
+// paralelo (Sim/sweep.h). Cada carga se genera una vez por (patrón, PEs) y la comparten todas sus corridas.
+//
+// Uso: bench_sweep [resultados.csv] [hilos=0] [ops_por_pe=2000] [lista_pes=4,8,16,32]
+//                  [lista_lineas=8,32] [protocolo=MESI|MOESI|MESIF|all] [lista_bancos=1,4]
+//                  [coherencia=snoop|directory|all]
+//
+// hilos=0 usa todos los núcleos. Para medir la escala, correr el mismo barrido con hilos=1 y con N.
+// Con coherencia=all cada configuración corre en snoop y en directorio sobre la misma carga, en filas
+// consecutivas: snoops_per_op y filtered_snoops_per_op (consultas que la difusión habría sumado) junto
+// a la latencia por acceso de cada modo.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../Sim/sweep.h"
+#include "../Workload/synthetic.h"
+
+using namespace std;
+
+namespace {
+
+vector<size_t> parse_list(const string& text) {
+    vector<size_t> out;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        size_t n = strtoull(item.c_str(), nullptr, 10);
+        if (n > 0) out.push_back(n);
+    }
+    return out;
+}
+
+vector<ProtocolKind> parse_protocols(const string& text) {
+    if (text == "all") return {ProtocolKind::MESI, ProtocolKind::MOESI, ProtocolKind::MESIF};
+    if (text == "MOESI") return {ProtocolKind::MOESI};
+    if (text == "MESIF") return {ProtocolKind::MESIF};
+    return {ProtocolKind::MESI};
+}
+
+vector<CoherenceMode> parse_coherence_modes(const string& text) {
+    if (text == "snoop") return {CoherenceMode::SNOOP};
+    if (text == "directory") return {CoherenceMode::DIRECTORY};
+    return {CoherenceMode::SNOOP, CoherenceMode::DIRECTORY};
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    string results_path = argc > 1 ? argv[1] : "bench_sweep.csv";
+    size_t workers = argc > 2 ? strtoull(argv[2], nullptr, 10) : 0;
+    size_t ops_per_pe = argc > 3 ? strtoull(argv[3], nullptr, 10) : 2000;
+    vector<size_t> pe_counts = parse_list(argc > 4 ? argv[4] : "4,8,16,32");
+    vector<size_t> cache_sizes = parse_list(argc > 5 ? argv[5] : "8,32");
+    vector<ProtocolKind> protocols = parse_protocols(argc > 6 ? argv[6] : "all");
+    vector<size_t> bank_counts = parse_list(argc > 7 ? argv[7] : "1,4");
+    vector<CoherenceMode> coherence_modes = parse_coherence_modes(argc > 8 ? argv[8] : "all");
+
+    vector<unique_ptr<WorkloadTrace>> traces;                                           // Dueñas de las cargas compartidas
+    SweepRunner sweep(workers);
+    for (size_t p = 0; p < NUM_SYNTHETIC_PATTERNS; ++p) {
+        for (size_t pes : pe_counts) {
+            SyntheticConfig workload;
+            workload.pattern = static_cast<SyntheticPattern>(p);
+            workload.num_pes = static_cast<int>(pes);
+            workload.ops_per_pe = ops_per_pe;
+            traces.push_back(make_unique<WorkloadTrace>());
+            if (!make_synthetic_trace(workload, *traces.back())) return 1;
+
+            for (ProtocolKind protocol : protocols) {
+                for (size_t lines : cache_sizes) {
+                    for (size_t banks : bank_counts) {
+                        for (CoherenceMode mode : coherence_modes) {
+                            SimConfig config;
+                            config.num_pes = static_cast<int>(pes);
+                            config.protocol = protocol;
+                            config.coherence_mode = mode;
+                            config.cache_lines = lines;
+                            config.num_banks = banks;
+                            sweep.add(synthetic_pattern_name(workload.pattern), *traces.back(), config);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<SweepResult> results = sweep.run();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (!write_sweep_csv(results_path, results)) return 1;
+    uint64_t operations = 0;
+    for (const SweepResult& r : results) operations += r.run.operations;
+    cout << "# " << results.size() << " simulaciones en " << seconds << " s con " << sweep.workers() << " hilos ("
+         << (seconds > 0.0 ? operations / seconds : 0.0) << " accesos simulados/s), resultados en " << results_path << endl;
+    return 0;
+}
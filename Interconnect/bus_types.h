@@ -1,7 +1,22 @@
 #ifndef BUS_TYPES_H
 #define BUS_TYPES_H
 
-enum MessageType {
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+constexpr size_t WORDS_PER_LINE = 4;                                                    // Doubles por línea de caché
+constexpr size_t ADDRESS_SPACE_WORDS = size_t(1) << 16;                                 // Direcciones uint16_t de los PEs
+constexpr size_t NUM_BLOCKS = ADDRESS_SPACE_WORDS / WORDS_PER_LINE;
+
+// Bloque (línea) al que pertenece una dirección
+inline size_t block_of(size_t address) {
+    return (address / WORDS_PER_LINE) % NUM_BLOCKS;
+}
+
+enum MessageType : uint8_t {
     READ_MISS,
     WRITE_MISS,
     INVALIDATE,
@@ -9,14 +24,42 @@ enum MessageType {
     FLUSH,
     READ,
     WRITE,
+    UPGRADE,                                                                            // S/O/F -> M: invalida a los demás sin mover datos
+    RMW,                                                                                // Acceso atómico del PE (RMW, LL/SC); como READ/WRITE, solo en trazas
+    MESSAGE_TYPE_COUNT,                                                                 // Centinela: cantidad de tipos
+};
+
+constexpr size_t NUM_MESSAGE_TYPES = static_cast<size_t>(MESSAGE_TYPE_COUNT);
+
+inline const char* message_type_name(MessageType type) {
+    static const char* const names[NUM_MESSAGE_TYPES] = {
+        "READ_MISS", "WRITE_MISS", "INVALIDATE", "WRITE_BACK", "FLUSH", "READ", "WRITE", "UPGRADE", "RMW",
+    };
+    return static_cast<size_t>(type) < NUM_MESSAGE_TYPES ? names[type] : "UNKNOWN";
+}
+
+// Misses en vuelo por PE (MSHRs, ver MESIController). Cada MSHR tiene su ranura de respuesta en el
+// interconnect; la ranura UNTRACKED_REQUEST es para lo que el PE envía fuera de un MSHR.
+constexpr size_t MAX_MSHRS = 16;
+constexpr uint8_t UNTRACKED_REQUEST = MAX_MSHRS;
+constexpr size_t REQUEST_SLOTS = MAX_MSHRS + 1;
+
+// Prioridad de una solicitud en la cola de su banco: los prefetches solo obtienen el bus cuando no
+// hay solicitudes de demanda esperando
+enum class BusPriority : uint8_t {
+    DEMAND,
+    PREFETCH,
 };
 
+// Encabezado compacto de 8 bytes, sin datos: la línea de un miss se entrega en la transacción
+// (Interconnect::handle_cache_miss) y la víctima sucia va a memoria con write_back_victim.
 struct BusMessage {
-    int sender_id;
-    MessageType type;
-    size_t address;
-    double data;
-    array<double, 4> cache_line;
+    uint32_t address = 0;
+    int16_t sender_id = 0;
+    MessageType type = READ_MISS;
+    uint8_t mshr = UNTRACKED_REQUEST;                                                   // Ranura de respuesta del solicitante
 };
 
+static_assert(sizeof(BusMessage) == 8, "BusMessage debe mantenerse compacto");
+
 #endif
@@ -0,0 +1,54 @@
+#include <algorithm>
+
+#include "directory.h"
+
+using namespace std;
+
+Directory::Directory(int num_pes)
+    : num_pes_(num_pes), words_per_entry_((static_cast<size_t>(num_pes) + 63) / 64),
+      presence_(make_unique<atomic<uint64_t>[]>(NUM_BLOCKS * words_per_entry_)),
+      owner_(make_unique<atomic<int16_t>[]>(NUM_BLOCKS)) {
+    for (size_t i = 0; i < NUM_BLOCKS * words_per_entry_; ++i) presence_[i].store(0, memory_order_relaxed);
+    for (size_t i = 0; i < NUM_BLOCKS; ++i) owner_[i].store(-1, memory_order_relaxed);
+}
+
+
+bool Directory::has_sharers(size_t address) const {
+    const atomic<uint64_t>* bits = &presence_[block_of(address) * words_per_entry_];
+    return any_of(bits, bits + words_per_entry_, [](const atomic<uint64_t>& word) { return word.load(memory_order_relaxed) != 0; });
+}
+
+
+void Directory::add_sharer(size_t address, int pe_id) {
+    if (pe_id < 0 || pe_id >= num_pes_) return;
+    size_t block = block_of(address);
+    presence_[block * words_per_entry_ + pe_id / 64].fetch_or(uint64_t(1) << (pe_id % 64), memory_order_relaxed);
+    if (owner_[block].load(memory_order_relaxed) != pe_id) {                            // El dueño anterior pasa a compartir
+        owner_[block].store(-1, memory_order_relaxed);
+    }
+}
+
+
+void Directory::set_owner(size_t address, int pe_id) {
+    if (pe_id < 0 || pe_id >= num_pes_) return;
+    size_t block = block_of(address);
+    atomic<uint64_t>* bits = &presence_[block * words_per_entry_];
+    for (size_t w = 0; w < words_per_entry_; ++w) bits[w].store(0, memory_order_relaxed);
+    bits[pe_id / 64].store(uint64_t(1) << (pe_id % 64), memory_order_relaxed);
+    owner_[block].store(static_cast<int16_t>(pe_id), memory_order_relaxed);
+}
+
+
+void Directory::remove(size_t address, int pe_id) {
+    if (pe_id < 0 || pe_id >= num_pes_) return;
+    size_t block = block_of(address);
+    presence_[block * words_per_entry_ + pe_id / 64].fetch_and(~(uint64_t(1) << (pe_id % 64)), memory_order_relaxed);
+    int16_t expected = static_cast<int16_t>(pe_id);
+    owner_[block].compare_exchange_strong(expected, -1, memory_order_relaxed);
+}
+
+
+void Directory::clear() {
+    for (size_t i = 0; i < NUM_BLOCKS * words_per_entry_; ++i) presence_[i].store(0, memory_order_relaxed);
+    for (size_t i = 0; i < NUM_BLOCKS; ++i) owner_[i].store(-1, memory_order_relaxed);
+}
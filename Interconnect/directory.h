@@ -0,0 +1,56 @@
+#ifndef DIRECTORY_H
+#define DIRECTORY_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "bus_types.h"
+
+using namespace std;
+
+// Modo de coherencia del interconnect: broadcast a todos los PEs o directorio
+enum class CoherenceMode {
+    SNOOP,
+    DIRECTORY,
+};
+
+// Directorio plano indexado por bloque: vector de presencia (un bit por PE) y dueño exclusivo.
+// Es conservador: un PE puede figurar como sharer tras desalojar la línea en silencio,
+// lo que solo cuesta una consulta extra, nunca una pérdida de coherencia.
+// Las entradas son atómicas: con bancos (o bus split) la transacción de un bloque puede coincidir
+// con el write-back de ese mismo bloque como víctima de otra transacción.
+class Directory {
+public:
+    explicit Directory(int num_pes);
+
+    int owner(size_t address) const { return owner_[block_of(address)].load(memory_order_relaxed); }
+    bool has_sharers(size_t address) const;
+
+    // Llama f(pe) por cada PE presente en el bloque, salvo exclude
+    template <typename F>
+    void for_each_sharer(size_t address, int exclude, F&& f) const {
+        const atomic<uint64_t>* bits = &presence_[block_of(address) * words_per_entry_];
+        for (size_t w = 0; w < words_per_entry_; ++w) {
+            uint64_t word = bits[w].load(memory_order_relaxed);
+            while (word) {
+                int pe = static_cast<int>(w * 64 + __builtin_ctzll(word));
+                word &= word - 1;
+                if (pe != exclude) f(pe);
+            }
+        }
+    }
+
+    void add_sharer(size_t address, int pe_id);                                         // READ_MISS servido por otra caché
+    void set_owner(size_t address, int pe_id);                                          // Única copia (E/M): WRITE_MISS, INVALIDATE o fill de memoria
+    void remove(size_t address, int pe_id);                                             // WRITE_BACK / desalojo
+    void clear();                                                                       // Sin sharers ni dueños (restauración de checkpoint)
+
+private:
+    int num_pes_;
+    size_t words_per_entry_;
+    unique_ptr<atomic<uint64_t>[]> presence_;                                           // NUM_BLOCKS * words_per_entry_
+    unique_ptr<atomic<int16_t>[]> owner_;                                               // -1 si no hay dueño exclusivo
+};
+
+#endif // DIRECTORY_H
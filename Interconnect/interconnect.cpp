@@ -1,14 +1,55 @@
+#include <chrono>
 #include <iostream>
+#include <thread>
 
 #include "interconnect.h"
 #include "Interconnect/bus_types.h"
 #include "../MESI/MESIController.h"
+#include "../Stats/line_profiler.h"
+#include "../Trace/trace.h"
 
 using namespace std;
 
-Interconnect::Interconnect(int num_pes, Memoria* memoria, size_t queue_depth)
-    : num_pes(num_pes), queue_depth_(queue_depth), main_memory_(memoria) {
+namespace {
+
+uint64_t now_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Latencia de memoria acumulada por la transacción que corre en este hilo (árbitro en ATOMIC, PE en SPLIT)
+thread_local uint64_t transaction_memory_ns = 0;
+
+}
+
+Interconnect::Interconnect(int num_pes, Memoria* memoria, size_t queue_depth, size_t num_banks, CoherenceMode mode,
+                           BusMode bus_mode, const DramConfig& dram, const TopologyConfig& topology)
+    : main_memory_(memoria), memory_(memoria, dram), created_ns_(now_ns()), num_pes(num_pes), queue_depth_(queue_depth), mode_(mode), bus_mode_(bus_mode),
+      directory_(mode == CoherenceMode::DIRECTORY ? num_pes : 0), snoop_states_(num_pes),
+      stats_(num_pes), log_stream_(sim_log_target()) {
     mesi_controllers.resize(num_pes, nullptr);
+    pe_slots_ = make_unique<CompletionSlot[]>(num_pes);
+    if (topology.pes_per_cluster > 0) topology_ = make_unique<Topology>(topology, num_pes);
+    if (bus_mode_ == BusMode::SPLIT) {
+        block_in_flight_.assign(NUM_BLOCKS, 0);
+    }
+    for (size_t i = 0; i < max<size_t>(num_banks, 1); ++i) {
+        banks_.push_back(make_unique<Bank>(queue_depth));
+    }
+    if (bus_mode_ != BusMode::INLINE) {
+        for (auto& bank : banks_) bank->arbiter = thread(&Interconnect::arbiter_loop, this, ref(*bank));
+    }
+}
+
+
+Interconnect::~Interconnect() {
+    for (auto& bank : banks_) {
+        bank->ring.close();
+        bank->low_ring.close();
+    }
+    for (auto& bank : banks_) {
+        if (bank->arbiter.joinable()) bank->arbiter.join();
+    }
+    memory_.flush(memory_time());                                                       // Memoria queda con los write-backs pendientes
 }
 
 
@@ -16,90 +57,258 @@ Interconnect::Interconnect(int num_pes, Memoria* memoria, size_t queue_depth)
 // ====================================================================================METODOS PRINCIPALES
 
 
-// Procesa un mensaje específico del bus
+// Procesa un mensaje específico del bus: el PE espera en su propia ranura hasta que el árbitro
+// complete la transacción (ATOMIC) o le conceda la fase de respuesta (SPLIT)
 optional<InterconnectResponse> Interconnect::process_messages(const BusMessage& msg) {
 
-    unique_lock<mutex> lock(bus_mutex);
+    if (fast_forward_) return execute_transaction(msg);                                 // Solo el efecto funcional
 
-    
-    bus_cv.wait(lock, [&] {
-        return bus_queue.size() > 0 && bus_queue.front().sender_id == msg.sender_id && (current_active_pe_id == -1 || current_active_pe_id == msg.sender_id);
-    });
+    if (bus_mode_ == BusMode::SPLIT) return process_split_response(msg);
+    if (bus_mode_ == BusMode::INLINE) return process_inline(msg);
 
-    // Marca el PE actual como activo
-    current_active_pe_id = msg.sender_id;
-    bus_cv.notify_all();
+    return wait_completion(msg);
+}
 
-    cout << "[Interconnect] PE " << msg.sender_id << " tiene el turno para procesar su mensaje." << endl;
-    optional<InterconnectResponse> result;
-    switch (bus_queue.front().type) {
-        case READ_MISS: {
-            InterconnectResponse resp = handle_cache_miss(bus_queue.front());
-            result = resp;
-            break;
-        }
-        case WRITE_MISS: {
-            InterconnectResponse resp = handle_cache_miss(bus_queue.front());
-            result = resp;
-            break;
+
+// Espera a que alguna de las ranuras de mshr_mask tenga su respuesta (o concesión) y devuelve su
+// índice sin consumirla; en INLINE nada corre por detrás, así que devuelve la primera, con las de
+// demanda antes que los prefetches.
+uint8_t Interconnect::wait_any_completion(int pe_id, uint32_t mshr_mask) {
+    if (bus_mode_ == BusMode::INLINE || fast_forward_ || mshr_mask == 0) {
+        uint32_t demand = mshr_mask & ~pe_slots_[pe_id].low_priority;
+        return static_cast<uint8_t>(mshr_mask ? __builtin_ctz(demand ? demand : mshr_mask) : 0);
+    }
+
+    CompletionSlot& slot = pe_slots_[pe_id];
+    unique_lock<mutex> lock(slot.m);
+    slot.cv.wait(lock, [&] { return (slot.ready & mshr_mask) != 0; });
+    return static_cast<uint8_t>(__builtin_ctz(slot.ready & mshr_mask));
+}
+
+
+// Ranuras de mshr_mask que process_messages atendería sin esperar. En INLINE y en fast-forward son
+// todas: la transacción corre recién cuando el PE la procesa.
+uint32_t Interconnect::poll_completions(int pe_id, uint32_t mshr_mask) {
+    if (bus_mode_ == BusMode::INLINE || fast_forward_ || mshr_mask == 0) return mshr_mask;
+
+    CompletionSlot& slot = pe_slots_[pe_id];
+    lock_guard<mutex> lock(slot.m);
+    return slot.ready & mshr_mask;
+}
+
+
+// Congestión del banco de la dirección: solicitudes esperando (ambas prioridades; en SPLIT también
+// las transacciones concedidas) sobre queue_depth. En INLINE no hay cola.
+double Interconnect::queue_occupancy(size_t address) const {
+    if (bus_mode_ == BusMode::INLINE || queue_depth_ == 0) return 0.0;
+    const Bank& bank = *banks_[bank_of(address)];
+    size_t waiting = bank.ring.size_approx() + bank.low_ring.size_approx();
+    if (bus_mode_ == BusMode::SPLIT) waiting += split_backlog_.load(memory_order_relaxed) / banks_.size();
+    return static_cast<double>(waiting) / queue_depth_;
+}
+
+
+// Envía un mensaje al interconnect. Si la cola está llena el PE espera espacio (contrapresión),
+// el mensaje de demanda nunca se descarta; un prefetch que no entra se descarta y retorna false.
+bool Interconnect::send_message(const BusMessage& msg, BusPriority priority) {
+
+    if (fast_forward_) return true;                                                     // process_messages aplica la transacción
+
+    CompletionSlot& slot = pe_slots_[msg.sender_id];
+    uint32_t bit = 1u << msg.mshr;
+    slot.low_priority = priority == BusPriority::PREFETCH ? (slot.low_priority | bit) : (slot.low_priority & ~bit);
+    slot.enqueue_ns[msg.mshr] = now_ns();
+
+    Bank& bank = *banks_[bank_of(msg.address)];
+    bool queued = false;
+    if (priority == BusPriority::PREFETCH && bus_mode_ != BusMode::INLINE) {
+        if (!bank.low_ring.try_push(msg)) return false;                                 // Sin lugar: el prefetch no se envía
+        bank.ring.wake_consumer();                                                      // El árbitro puede estar esperando en ring
+        queued = true;
+    }
+
+    SIM_LOG("[PE " << msg.sender_id << "] Solicita acceso al bus para mensaje tipo " << message_type_name(msg.type) << " en dirección " << msg.address);
+
+    bus_traffic++;                                                                      // Incrementa el tráfico del bus
+    stats_.pe(msg.sender_id).messages_sent[msg.type].fetch_add(1, memory_order_relaxed);
+    mark_first_request();
+    trace(TraceEvent::BUS_ENQUEUE, msg);
+
+    if constexpr (trace_enabled<TraceLevel::VERBOSE>()) {
+        if (ostream* log = sim_log_target()) print_bus_state(*log);
+    }
+
+    if (bus_mode_ == BusMode::INLINE || queued) return true;                            // INLINE: process_messages ejecuta la transacción
+
+    bank.ring.push(msg);                                                                // Encola en su banco (espera si no hay espacio)
+
+    SIM_LOG("[PE " << msg.sender_id << "] Mensaje encolado. Esperando turno...");
+    return true;
+}
+
+
+// Hilo árbitro de un banco: único consumidor de sus dos colas; la de prefetches solo se atiende
+// cuando la de demanda está vacía
+void Interconnect::arbiter_loop(Bank& bank) {
+    SimLogRedirect log(log_stream_);                                                    // Misma bitácora que quien creó el sistema
+    BusMessage msg;
+    bool prefetch = false;
+    while (bank.ring.pop_wait(msg, [&](BusMessage& low) { return prefetch = bank.low_ring.try_pop(low); })) {
+
+        if (bus_mode_ == BusMode::SPLIT) {                                              // Solo la fase de solicitud
+            if (prefetch) {
+                run_split_prefetch(msg);
+            } else {
+                grant_split_request(msg);
+            }
+            prefetch = false;
+            continue;
         }
-        case INVALIDATE:
-            handle_invalidate(bus_queue.front());
-            result = nullopt;
-            break;
-        case WRITE_BACK:
-            handle_write_back(bus_queue.front());
-            result = nullopt;
-            break;
-        default:
-            cerr << "[Interconnect] Tipo de mensaje desconocido." << endl;
-            result = nullopt;
-            break;
+
+        uint64_t grant_ns = now_ns();
+        trace(TraceEvent::BUS_GRANT, msg);
+        SIM_LOG("[Interconnect] PE " << msg.sender_id << " tiene el turno para procesar su mensaje.");
+
+        optional<InterconnectResponse> result = execute_transaction(msg);
+
+        record_completion(msg, grant_ns);
+        trace(TraceEvent::BUS_COMPLETE, msg);
+        SIM_LOG("[Interconnect] Mensaje de PE " << msg.sender_id << " procesado y removido de la cola.");
+
+        complete(msg, move(result));
+    }
+}
+
+
+// Entrega el resultado (o la concesión en SPLIT) en la ranura del mensaje y despierta solo a su PE.
+// finished: en SPLIT, la transacción ya no necesita fase de respuesta (ver run_split_prefetch).
+void Interconnect::complete(const BusMessage& msg, optional<InterconnectResponse> result, bool finished) {
+    CompletionSlot& slot = pe_slots_[msg.sender_id];
+    uint32_t bit = 1u << msg.mshr;
+    {
+        lock_guard<mutex> lock(slot.m);
+        slot.result[msg.mshr] = move(result);
+        slot.ready |= bit;
+        slot.finished = finished ? (slot.finished | bit) : (slot.finished & ~bit);
     }
+    slot.cv.notify_one();                                                               // Solo el hilo del PE espera en sus ranuras
+}
+
+
+optional<InterconnectResponse> Interconnect::wait_completion(const BusMessage& msg, bool* finished) {
+    CompletionSlot& slot = pe_slots_[msg.sender_id];
+    uint32_t bit = 1u << msg.mshr;
+    unique_lock<mutex> lock(slot.m);
+    slot.cv.wait(lock, [&] { return (slot.ready & bit) != 0; });
+    slot.ready &= ~bit;
+    if (finished) *finished = (slot.finished & bit) != 0;
+    return move(slot.result[msg.mshr]);
+}
+
 
-    // Remueve el mensaje procesado de la cola
-    bus_queue.pop();
-    cout << "[Interconnect] Mensaje de PE " << msg.sender_id << " procesado y removido de la cola." << endl;
+// ==================================================================================== BUS SPLIT-TRANSACTION ===
 
-    // Actualiza el PE activo con el siguiente en la cola o -1 si está vacía
-    if (!bus_queue.empty()) {
-        current_active_pe_id = bus_queue.front().sender_id;
+
+// Fase de solicitud (hilo árbitro): el mensaje obtiene el bus de inmediato si su bloque no tiene otra
+// transacción en vuelo y hay capacidad (queue_depth); si no, espera en orden de llegada.
+void Interconnect::grant_split_request(const BusMessage& msg) {
+    lock_guard<mutex> lock(split_mutex_);
+
+    if (can_issue_split(msg)) {                                                         // Lo pendiente ya está bloqueado por su propio bloque
+        issue_split(msg);
     } else {
-        current_active_pe_id = -1;
+        pending_split_.push_back(msg);
     }
-    bus_cv.notify_all();
+    split_backlog_.store(in_flight_ + pending_split_.size(), memory_order_relaxed);
+}
 
-    return result;
+
+// Prefetch en SPLIT (hilo árbitro): se ejecuta completo aquí mismo si su bloque está libre y hay
+// capacidad, y si no se descarta (resultado vacío). Nunca queda una concesión esperando al PE, que
+// podría no volver a llamar al controlador por un buen rato.
+void Interconnect::run_split_prefetch(const BusMessage& msg) {
+    {
+        lock_guard<mutex> lock(split_mutex_);
+        if (!can_issue_split(msg)) {
+            complete(msg, nullopt, true);
+            return;
+        }
+        block_in_flight_[block_of(msg.address)] = 1;
+        in_flight_++;
+    }
+
+    uint64_t grant_ns = now_ns();
+    trace(TraceEvent::BUS_GRANT, msg);
+    optional<InterconnectResponse> result = execute_transaction(msg);
+    release_split(msg);
+    record_completion(msg, grant_ns);
+    trace(TraceEvent::BUS_COMPLETE, msg);
+    complete(msg, move(result), true);
 }
 
 
-// Envía un mensaje al interconnect y espera su turno para usar el bus
-void Interconnect::send_message(const BusMessage& msg) {
+// Fase de respuesta: espera la concesión en la ranura propia del PE y ejecuta la transacción
+// sin retener el bus; solo se serializan transacciones al mismo bloque.
+optional<InterconnectResponse> Interconnect::process_split_response(const BusMessage& msg) {
+    bool finished = false;
+    optional<InterconnectResponse> granted = wait_completion(msg, &finished);
+    if (finished) return granted;                                                       // Prefetch ya resuelto por el árbitro
 
-    unique_lock<mutex> lock(bus_mutex);                                             // Bloquea el mutex del bus
+    uint64_t grant_ns = now_ns();
+    trace(TraceEvent::BUS_GRANT, msg);
+    SIM_LOG("[Interconnect] PE " << msg.sender_id << " inicia fase de respuesta para dirección " << msg.address);
+    optional<InterconnectResponse> result = execute_transaction(msg);
+    release_split(msg);
 
-    if (bus_queue.size() < queue_depth_) {                                          // Si hay espacio en la cola
+    record_completion(msg, grant_ns);
+    trace(TraceEvent::BUS_COMPLETE, msg);
+    return result;
+}
 
-        cout << "[PE " << msg.sender_id << "] Solicita acceso al bus para mensaje tipo " << msg.type << " en dirección " << msg.address << endl;
-        
-        bus_queue.push(msg);                                                        // Encola el mensaje
-        bus_traffic++;                                                              // Incrementa el tráfico del bus
-        
-        print_bus_state();
 
-        cout << "[PE " << msg.sender_id << "] Mensaje encolado. Esperando turno..." << endl;
-        
-        bus_cv.notify_all();                                                        // Notifica a los PEs que hay un nuevo mensaje
-        
-        bus_cv.wait(lock, [&] {                                                     // Espera hasta que sea su turno, re
-            return current_active_pe_id != msg.sender_id;
-        });
-        
-        cout << "[PE " << msg.sender_id << "] Turno concedido." << endl;
-        
-    } else {
-        cerr << "[Interconnect] Cola de mensajes llena. Mensaje descartado." << endl;
+// Libera el bloque y concede en orden de llegada lo pendiente que ya no tenga conflicto
+void Interconnect::release_split(const BusMessage& msg) {
+    lock_guard<mutex> lock(split_mutex_);
+    block_in_flight_[block_of(msg.address)] = 0;
+    in_flight_--;
+
+    for (auto it = pending_split_.begin(); it != pending_split_.end();) {
+        if (in_flight_ >= queue_depth_) break;
+        if (can_issue_split(*it)) {
+            issue_split(*it);
+            it = pending_split_.erase(it);
+        } else {
+            ++it;
+        }
     }
+    split_backlog_.store(in_flight_ + pending_split_.size(), memory_order_relaxed);
+}
+
+
+bool Interconnect::can_issue_split(const BusMessage& msg) const {
+    return in_flight_ < queue_depth_ && !block_in_flight_[block_of(msg.address)];
+}
+
+
+// Marca el bloque en vuelo y concede la fase de respuesta al PE (requiere split_mutex_)
+void Interconnect::issue_split(const BusMessage& msg) {
+    block_in_flight_[block_of(msg.address)] = 1;
+    in_flight_++;
+    complete(msg, nullopt);
+}
+
+
+// ==================================================================================== BUS INLINE ===
+
+
+// Sin árbitro: la transacción corre completa en el hilo del solicitante (un único hilo de simulación)
+optional<InterconnectResponse> Interconnect::process_inline(const BusMessage& msg) {
+    uint64_t grant_ns = now_ns();
+    trace(TraceEvent::BUS_GRANT, msg);
+    optional<InterconnectResponse> result = execute_transaction(msg);
+    record_completion(msg, grant_ns);
+    trace(TraceEvent::BUS_COMPLETE, msg);
+    return result;
 }
 
 
@@ -110,65 +319,486 @@ void Interconnect::send_message(const BusMessage& msg) {
 void Interconnect::attach_mesi_controller(MESIController* mesi, int pe_id) {
     if (pe_id >= 0 && pe_id < num_pes) {
         if (mesi_controllers.size() < num_pes) mesi_controllers.resize(num_pes, nullptr);
+        attached_pes_ += (mesi != nullptr) - (mesi_controllers[pe_id] != nullptr);
         mesi_controllers[pe_id] = mesi;
     }
 }
 
 
+// Fija el reloj del modelo de memoria (ns simulados). Lo usa el motor de eventos; sin llamarlo,
+// la memoria usa el tiempo de reloj desde la creación del interconnect.
+void Interconnect::set_sim_time(uint64_t ns) {
+    sim_now_ns_.store(ns, memory_order_relaxed);
+    external_clock_.store(true, memory_order_relaxed);
+}
+
+
+uint64_t Interconnect::memory_time() const {
+    if (external_clock_.load(memory_order_relaxed)) return sim_now_ns_.load(memory_order_relaxed);
+    return now_ns() - created_ns_;
+}
+
+
+// Escribe en Memoria los write-backs que siguen en el buffer
+void Interconnect::flush_memory() {
+    memory_.flush(memory_time());
+}
+
+
+// Fast-forward: las transacciones se aplican en el hilo que las pide, sin cola, árbitro, trazas ni
+// modelo de tiempo de la memoria. Solo con un único hilo usando el sistema (ver Sim/checkpoint.h).
+void Interconnect::begin_fast_forward() {
+    if (fast_forward_) return;
+    flush_memory();                                                                     // Memoria se usa directo: nada puede quedar en el buffer
+    saved_trace_sink_ = trace_sink_;
+    trace_sink_ = nullptr;
+    saved_line_profiler_ = line_profiler_;
+    line_profiler_ = nullptr;
+    fast_forward_ = true;
+}
+
+
+// Vuelve al modo detallado; los contadores arrancan de cero
+void Interconnect::end_fast_forward() {
+    if (!fast_forward_) return;
+    fast_forward_ = false;
+    trace_sink_ = saved_trace_sink_;
+    line_profiler_ = saved_line_profiler_;
+    reset_stats();
+}
+
+
+void Interconnect::reset_stats() {
+    stats_.reset();
+    bus_traffic = 0;
+    snoop_messages = 0;
+    filtered_snoops_.store(0, memory_order_relaxed);
+    completed_transactions_.store(0, memory_order_relaxed);
+    first_request_ns_.store(0, memory_order_relaxed);
+    last_completion_ns_.store(0, memory_order_relaxed);
+    for (auto& bank : banks_) {
+        bank->transactions.store(0, memory_order_relaxed);
+        bank->busy_ns.store(0, memory_order_relaxed);
+    }
+    if (topology_) topology_->stats().reset();
+}
+
+
+Interconnect::BusCounters Interconnect::bus_counters() const {
+    BusCounters counters;
+    counters.bus_traffic = static_cast<uint64_t>(bus_traffic.load());
+    counters.snoop_messages = static_cast<uint64_t>(snoop_messages.load());
+    counters.filtered_snoops = get_filtered_snoops();
+    counters.completed_transactions = get_completed_transactions();
+    for (const auto& bank : banks_) {
+        counters.bank_transactions.push_back(bank->transactions.load(memory_order_relaxed));
+        counters.bank_busy_ns.push_back(bank->busy_ns.load(memory_order_relaxed));
+    }
+    return counters;
+}
+
+
+bool Interconnect::restore_bus_counters(const BusCounters& counters) {
+    if (counters.bank_transactions.size() != banks_.size() || counters.bank_busy_ns.size() != banks_.size()) {
+        cerr << "[Interconnect] Contadores de " << counters.bank_transactions.size() << " bancos para un bus de "
+             << banks_.size() << endl;
+        return false;
+    }
+    bus_traffic = static_cast<int>(counters.bus_traffic);
+    snoop_messages = static_cast<int>(counters.snoop_messages);
+    filtered_snoops_.store(counters.filtered_snoops, memory_order_relaxed);
+    completed_transactions_.store(counters.completed_transactions, memory_order_relaxed);
+    for (size_t i = 0; i < banks_.size(); ++i) {
+        banks_[i]->transactions.store(counters.bank_transactions[i], memory_order_relaxed);
+        banks_[i]->busy_ns.store(counters.bank_busy_ns[i], memory_order_relaxed);
+    }
+    return true;
+}
+
+
+uint32_t Interconnect::read_memory(size_t address, array<double,4>& linea) {
+    if (fast_forward_) {
+        linea = main_memory_ ? main_memory_->read_bloque(address) : array<double,4>{};
+        return 0;
+    }
+    uint32_t latency = memory_.read_line(address, linea, memory_time());
+    transaction_memory_ns += latency;
+    return latency;
+}
+
+
+uint32_t Interconnect::write_memory(size_t address, const array<double,4>& linea) {
+    if (fast_forward_) {
+        if (main_memory_) main_memory_->write_bloque(address, linea);
+        return 0;
+    }
+    uint32_t latency = memory_.write_line(address, linea, memory_time());
+    transaction_memory_ns += latency;
+    return latency;
+}
+
+
+// Con reloj real (ATOMIC y SPLIT) la transacción no termina antes de que pase la latencia modelada de sus
+// accesos a memoria: el banco (ATOMIC) o el bloque (SPLIT) queda ocupado ese tiempo. Con reloj simulado
+// (motor de eventos, INLINE) el tiempo lo cobra quien avanza el reloj a partir de MemoryStats.
+void Interconnect::wait_memory(uint64_t start_ns) const {
+    if (bus_mode_ == BusMode::INLINE || external_clock_.load(memory_order_relaxed)) return;
+    uint64_t ready_ns = start_ns + transaction_memory_ns;
+    while (now_ns() < ready_ns) this_thread::yield();
+}
+
+
+// Miss que ninguna caché entregó. Con topología lo sirve la L2 del cluster si tiene el bloque (sus datos
+// son los de memoria, ver topology.h) y si no la memoria de su home, que puede estar en otro nodo.
+void Interconnect::read_memory_cached(const BusMessage& msg, array<double,4>& linea, uint32_t probe_hops) {
+    if (!topology_) {
+        read_memory(msg.address, linea);
+        return;
+    }
+
+    TopologyStats& topo = topology_->stats();
+    int cluster = topology_->cluster_of(msg.sender_id);
+    if (topology_->l2_lookup(cluster, msg.address)) {
+        topo.l2_hits.fetch_add(1, memory_order_relaxed);
+        if (fast_forward_) {
+            read_memory(msg.address, linea);
+        } else {
+            memory_.peek_line(msg.address, linea);                                      // Sin acceso a DRAM
+        }
+        topology_->charge_transaction(probe_hops);
+        return;
+    }
+
+    topo.l2_misses.fetch_add(1, memory_order_relaxed);
+    int home = topology_->home_of(msg.address, cluster);
+    (home == cluster ? topo.local_memory : topo.remote_memory).fetch_add(1, memory_order_relaxed);
+    topology_->count_messages(cluster, home, 2);                                        // Pedido y datos
+    read_memory(msg.address, linea);
+    topology_->charge_transaction(max(probe_hops, topology_->hops(cluster, home)));
+}
+
+
+// Escritura a memoria desde el cluster del PE: un mensaje hasta el home del bloque
+void Interconnect::count_home_traffic(int pe_id, size_t address) {
+    if (!topology_) return;
+    int cluster = topology_->cluster_of(pe_id);
+    topology_->count_messages(cluster, topology_->home_of(address, cluster), 1);
+}
+
+
+// Conecta (o desconecta con nullptr) el sumidero de trazas binarias
+void Interconnect::set_trace_sink(TraceSink* sink) {
+    trace_sink_ = sink;
+}
+
+
 // ==================================================================================== FUNCIONES AUXILIARES ===
 
 
+// Ejecuta la transacción según el tipo de mensaje y actualiza el directorio si corresponde
+optional<InterconnectResponse> Interconnect::execute_transaction(const BusMessage& msg) {
+    uint64_t start_ns = now_ns();
+    transaction_memory_ns = 0;
+    optional<InterconnectResponse> result;
+    switch (msg.type) {
+        case READ_MISS:
+        case WRITE_MISS:
+            result = handle_cache_miss(msg);
+            break;
+        case INVALIDATE:
+            handle_invalidate(msg);
+            break;
+        case UPGRADE:
+            result = handle_upgrade(msg);
+            break;
+        default:
+            cerr << "[Interconnect] Tipo de mensaje desconocido." << endl;
+            break;
+    }
+
+    if (mode_ == CoherenceMode::DIRECTORY) update_directory(msg, result);
+    wait_memory(start_ns);
+    return result;
+}
+
 
-InterconnectResponse Interconnect::handle_cache_miss(const BusMessage& msg) {
-    string tipo = (msg.type == WRITE_MISS) ? "WRITE_MISS" : "READ_MISS";
-    cout << "[VERIF-INTERCONNECT] INICIO " << tipo << ": PE " << msg.sender_id << " solicita dirección " << msg.address << endl;
-
-    optional<array<double,4>> linea;
-    bool from_memory = false;
-
-    for (int i = 0; i < num_pes; ++i) {
-        if (i != msg.sender_id && mesi_controllers.size() > i && mesi_controllers[i]) {
-            cout << "[VERIF-INTERCONNECT] Consultando MESIController de PE " << i << " por línea " << msg.address << endl;
-            linea = mesi_controllers[i]->process_bus_message(msg);
-            if (linea.has_value()) {
-                break;
+void Interconnect::mark_first_request() {
+    uint64_t expected = 0;
+    first_request_ns_.compare_exchange_strong(expected, now_ns(), memory_order_relaxed);
+}
+
+
+// Cuenta la transacción terminada y registra sus latencias (cola y servicio)
+void Interconnect::record_completion(const BusMessage& msg, uint64_t grant_ns) {
+    uint64_t done_ns = now_ns();
+    PeStats& pe = stats_.pe(msg.sender_id);
+    uint64_t enqueue_ns = pe_slots_[msg.sender_id].enqueue_ns[msg.mshr];
+    uint64_t queue_delay = grant_ns > enqueue_ns ? grant_ns - enqueue_ns : 0;
+    pe.queue_delay_ns.record(queue_delay);
+    if (line_profiler_) line_profiler_->on_queue_delay(msg.address, queue_delay);
+    pe.service_ns.record(done_ns - grant_ns);
+
+    Bank& bank = *banks_[bank_of(msg.address)];
+    bank.transactions.fetch_add(1, memory_order_relaxed);
+    bank.busy_ns.fetch_add(done_ns - grant_ns, memory_order_relaxed);
+
+    completed_transactions_.fetch_add(1, memory_order_relaxed);
+    uint64_t last = last_completion_ns_.load(memory_order_relaxed);                     // Varios bancos terminan en paralelo
+    while (done_ns > last && !last_completion_ns_.compare_exchange_weak(last, done_ns, memory_order_relaxed)) {}
+}
+
+
+// Recorre los PEs a consultar para un mensaje y devuelve la distancia (saltos) al cluster consultado más
+// lejano. Con topología cada cluster remoto se consulta una vez, a través de su L2, y solo si la L2 tiene
+// el bloque (es inclusiva); dentro del cluster la L2 reenvía a los PEs con la línea.
+// visit(pe) retorna true para detener el recorrido.
+template <typename F>
+uint32_t Interconnect::for_each_snoop_target(const BusMessage& msg, F&& visit) {
+    if (!topology_) {
+        for_each_holder_target(msg, visit);
+        return 0;
+    }
+
+    int own = topology_->cluster_of(msg.sender_id);
+    uint64_t probed = 0;
+    uint64_t skipped = 0;
+    uint64_t local = 0;
+    uint32_t max_hops = 0;
+    for_each_holder_target(msg, [&](int pe) {
+        int cluster = topology_->cluster_of(pe);
+        uint64_t bit = uint64_t(1) << cluster;
+        if (cluster == own) {
+            local++;
+            return visit(pe);
+        }
+        if (skipped & bit) return false;
+        if (!(probed & bit)) {
+            if (!topology_->l2_contains(cluster, msg.address)) {                        // Sin la línea en el cluster (filtrado)
+                skipped |= bit;
+                return false;
             }
+            probed |= bit;
+            max_hops = max(max_hops, topology_->hops(own, cluster));
         }
+        return visit(pe);
+    });
+
+    TopologyStats& topo = topology_->stats();
+    uint64_t remote = __builtin_popcountll(probed);
+    topo.local_snoops.fetch_add(local, memory_order_relaxed);
+    topo.remote_probes.fetch_add(remote, memory_order_relaxed);
+    topo.filtered_probes.fetch_add(topology_->num_clusters() - 1 - remote, memory_order_relaxed);
+    for (uint64_t mask = probed; mask; mask &= mask - 1) {
+        topology_->count_messages(own, __builtin_ctzll(mask), 2);                       // Consulta y respuesta
+    }
+    return max_hops;
+}
+
+
+// PEs a consultar: los que tienen la línea según el SnoopStateStore en modo SNOOP, solo dueño/sharers
+// en modo DIRECTORY
+template <typename F>
+void Interconnect::for_each_holder_target(const BusMessage& msg, F&& visit) {
+    auto attached = [&](int pe) {
+        return pe != msg.sender_id && pe < static_cast<int>(mesi_controllers.size()) && mesi_controllers[pe];
+    };
+
+    if (mode_ == CoherenceMode::SNOOP) {                                                // Solo los PEs que tienen la línea
+        snoop_states_.for_each_holder(msg.address, msg.sender_id, [&](int pe) { return attached(pe) && visit(pe); });
+        return;
+    }
+
+    int owner = directory_.owner(msg.address);                                          // Con dueño exclusivo basta consultarlo a él
+    if (owner >= 0 && owner != msg.sender_id) {
+        if (attached(owner)) visit(owner);
+        return;
     }
 
-    if (!linea.has_value()) {
-        cout << "[VERIF-INTERCONNECT] Línea NO encontrada en ningún PE, cargando de memoria principal para dirección " << msg.address << endl;
-        linea = array<double,4>{9.9,0.0,0.0,0.0}; // Línea simulada para pruebas
-        //linea = main_memory_->read_bloque(msg.address);
-        from_memory = true;
+    bool stop = false;
+    directory_.for_each_sharer(msg.address, msg.sender_id, [&](int pe) {
+        if (!stop && attached(pe)) stop = visit(pe);
+    });
+}
+
+
+// SNOOP: un bus de difusión consulta a todos los demás PEs en cada transacción (también un READ_MISS
+// ya servido); lo que no se envió lo filtró el SnoopStateStore (o la L2 de un cluster remoto)
+void Interconnect::count_filtered_snoops(uint32_t probes) {
+    if (mode_ != CoherenceMode::SNOOP) return;
+    uint32_t broadcast = attached_pes_ > 1 ? static_cast<uint32_t>(attached_pes_ - 1) : 0;
+    if (broadcast > probes) filtered_snoops_.fetch_add(broadcast - probes, memory_order_relaxed);
+}
+
+
+// Refleja en el directorio el resultado de una transacción ya completada
+void Interconnect::update_directory(const BusMessage& msg, const optional<InterconnectResponse>& response) {
+    switch (msg.type) {
+        case READ_MISS:
+            if (response.has_value() && !response->shared) {
+                directory_.set_owner(msg.address, msg.sender_id);                        // Única copia (EXCLUSIVE)
+            } else {
+                directory_.add_sharer(msg.address, msg.sender_id);
+            }
+            break;
+        case WRITE_MISS:
+        case INVALIDATE:
+        case UPGRADE:
+            directory_.set_owner(msg.address, msg.sender_id);
+            break;
+        default:
+            break;
+    }
+}
+
+
+// Registro binario de un evento del bus; desaparece si el nivel de traza compilado es OFF
+void Interconnect::trace(TraceEvent event, const BusMessage& msg, int target_pe) const {
+    trace_event(trace_sink_, event, msg.sender_id, target_pe, msg.address, static_cast<uint8_t>(msg.type));
+}
+
+
+
+InterconnectResponse Interconnect::handle_cache_miss(const BusMessage& msg) {
+    [[maybe_unused]] const char* tipo = (msg.type == WRITE_MISS) ? "WRITE_MISS" : "READ_MISS";
+    SIM_LOG("[VERIF-INTERCONNECT] INICIO " << tipo << ": PE " << msg.sender_id << " solicita dirección " << msg.address);
+
+    array<double,4> linea{};                                                            // El proveedor (caché o memoria) escribe aquí
+    bool supplied = false;
+    bool shared = false;
+    uint32_t probes = 0;
+
+    // READ_MISS se detiene en el primer proveedor; WRITE_MISS recorre a todos para invalidar cada copia
+    uint32_t probe_hops = for_each_snoop_target(msg, [&](int i) {
+        SIM_LOG("[VERIF-INTERCONNECT] Consultando MESIController de PE " << i << " por línea " << msg.address);
+        trace(TraceEvent::SNOOP, msg, i);
+        snoop_messages++;
+        probes++;
+        SnoopReply reply = mesi_controllers[i]->process_bus_message(msg, supplied ? nullptr : &linea);
+        shared |= reply.had_line;
+        if (line_profiler_ && reply.had_line && msg.type == WRITE_MISS) line_profiler_->on_invalidate(i, msg.address);
+        if (reply.supplied) {
+            supplied = true;
+            if (reply.flush) {                                                          // M -> S en MESI/MESIF: memoria queda al día
+                stats_.pe(i).flushes.fetch_add(1, memory_order_relaxed);
+                write_memory(msg.address, linea);
+                count_home_traffic(i, msg.address);
+            }
+        }
+        return supplied && msg.type == READ_MISS;
+    });
+    count_filtered_snoops(probes);
+
+    PeStats& requester = stats_.pe(msg.sender_id);
+    if (!supplied) {
+        requester.memory_fills.fetch_add(1, memory_order_relaxed);
+        SIM_LOG("[VERIF-INTERCONNECT] Línea NO entregada por ningún PE, cargando de memoria principal para dirección " << msg.address);
+        read_memory_cached(msg, linea, probe_hops);
     } else {
-        cout << "[VERIF-INTERCONNECT] Línea encontrada en algún PE para dirección " << msg.address << endl;
+        requester.cache_to_cache.fetch_add(1, memory_order_relaxed);
+        if (topology_) topology_->charge_transaction(probe_hops);
+        SIM_LOG("[VERIF-INTERCONNECT] Línea entregada por otro PE para dirección " << msg.address);
     }
 
-    cout << "[VERIF-INTERCONNECT] FIN " << tipo << " para dirección " << msg.address << endl;
-    return InterconnectResponse{*linea, from_memory};
+    if (line_profiler_) line_profiler_->on_miss(msg.sender_id, msg.type, msg.address, supplied);  // Antes de aplicar sus escrituras
+    mesi_controllers[msg.sender_id]->install_line(msg, linea, shared && msg.type == READ_MISS);
+
+    if (topology_) {                                                                    // Después de instalar: la L2 incluye a la L1
+        if (msg.type == WRITE_MISS) drop_remote_l2(msg);
+        fill_cluster_l2(msg.sender_id, msg.address);
+    }
+
+    SIM_LOG("[VERIF-INTERCONNECT] FIN " << tipo << " para dirección " << msg.address);
+    return InterconnectResponse{!supplied, shared};
 }
 
 
 void Interconnect::handle_invalidate(const BusMessage& msg) {
-    cout << "[VERIF-INTERCONNECT] Procesando INVALIDATE de PE " << msg.sender_id << " para dirección " << msg.address << endl;
-    for (int i = 0; i < num_pes; ++i) {
-        if (i != msg.sender_id && mesi_controllers.size() > i && mesi_controllers[i]) {
-            cout << "[VERIF-INTERCONNECT] Enviando INVALIDATE a PE " << i << " para dirección " << msg.address << endl;
-            mesi_controllers[i]->process_bus_message(msg);
-            cout << "[VERIF-INTERCONNECT] INVALIDATE procesado por PE " << i << " para dirección " << msg.address << endl;
+    SIM_LOG("[VERIF-INTERCONNECT] Procesando " << message_type_name(msg.type) << " de PE " << msg.sender_id << " para dirección " << msg.address);
+    uint32_t probes = 0;
+    uint32_t probe_hops = for_each_snoop_target(msg, [&](int i) {
+        SIM_LOG("[VERIF-INTERCONNECT] Enviando INVALIDATE a PE " << i << " para dirección " << msg.address);
+        trace(TraceEvent::SNOOP, msg, i);
+        snoop_messages++;
+        probes++;
+        stats_.pe(i).invalidations_received.fetch_add(1, memory_order_relaxed);
+        SnoopReply reply = mesi_controllers[i]->process_bus_message(msg);
+        if (line_profiler_ && reply.had_line) line_profiler_->on_invalidate(i, msg.address);
+        SIM_LOG("[VERIF-INTERCONNECT] INVALIDATE procesado por PE " << i << " para dirección " << msg.address);
+        return false;
+    });
+    count_filtered_snoops(probes);
+    if (topology_) {
+        drop_remote_l2(msg);
+        topology_->charge_transaction(probe_hops);
+    }
+    SIM_LOG("[VERIF-INTERCONNECT] FIN " << message_type_name(msg.type) << " para dirección " << msg.address);
+}
+
+
+// Víctima sucia desalojada al instalar otra línea: se escribe en memoria como parte de la transacción
+// que la desalojó, con la caché del PE aún bloqueada (ver MESIController::install_line)
+void Interconnect::write_back_victim(int pe_id, size_t address, const array<double,4>& linea) {
+    SIM_LOG("[VERIF-INTERCONNECT] WRITE_BACK de víctima de PE " << pe_id << " para dirección " << address);
+    PeStats& pe = stats_.pe(pe_id);
+    bus_traffic++;
+    pe.messages_sent[WRITE_BACK].fetch_add(1, memory_order_relaxed);
+    pe.write_backs.fetch_add(1, memory_order_relaxed);
+    write_memory(address, linea);
+    count_home_traffic(pe_id, address);
+    if (mode_ == CoherenceMode::DIRECTORY) directory_.remove(address, pe_id);
+}
+
+
+// Trae el bloque a la L2 del cluster del PE. Si desaloja otro bloque, lo invalida en las L1 del
+// cluster (las sucias van a memoria) antes de dejar de figurar en la L2: la L2 sigue siendo inclusiva.
+// Toma la caché de cada PE de a una; quien llama no debe tener ninguna bloqueada.
+void Interconnect::fill_cluster_l2(int pe_id, size_t address) {
+    if (!topology_) return;
+    int cluster = topology_->cluster_of(pe_id);
+    optional<size_t> victim = topology_->l2_fill(cluster, address);
+    if (!victim.has_value()) return;
+
+    snoop_states_.for_each_holder(*victim, -1, [&](int pe) {
+        if (topology_->cluster_of(pe) != cluster || pe >= static_cast<int>(mesi_controllers.size()) || !mesi_controllers[pe]) return false;
+        if (mesi_controllers[pe]->back_invalidate(*victim)) {
+            topology_->stats().back_invalidations.fetch_add(1, memory_order_relaxed);
+            if (mode_ == CoherenceMode::DIRECTORY) directory_.remove(*victim, pe);
         }
+        return false;
+    });
+    topology_->l2_finish_eviction(cluster, *victim);
+}
+
+
+// Escritura de otro cluster: sus copias ya se invalidaron, las L2 remotas sueltan la etiqueta
+void Interconnect::drop_remote_l2(const BusMessage& msg) {
+    int own = topology_->cluster_of(msg.sender_id);
+    for (size_t cluster = 0; cluster < topology_->num_clusters(); ++cluster) {
+        if (static_cast<int>(cluster) != own) topology_->l2_drop(static_cast<int>(cluster), msg.address);
     }
-    cout << "[VERIF-INTERCONNECT] FIN INVALIDATE para dirección " << msg.address << endl;
 }
 
 
-void Interconnect::handle_write_back(const BusMessage& msg) {
-    if (main_memory_) {
-        cout << "[Interconnect] Recibido WRITE_BACK de PE " << msg.sender_id << " para dirección " << msg.address << endl;
-        //main_memory_->write_bloque(msg.address, msg.cache_line);
-        cout << "[Interconnect] Línea escrita en memoria principal por WRITE_BACK." << endl;
+void Interconnect::clear_topology() {
+    if (topology_) topology_->clear();
+}
+
+
+// S/O/F -> M sin transferir datos. Se verifica dentro de la transacción que el solicitante siga
+// teniendo la línea: si otro PE la invalidó mientras esperaba el bus, se atiende como WRITE_MISS.
+InterconnectResponse Interconnect::handle_upgrade(const BusMessage& msg) {
+    if (!mesi_controllers[msg.sender_id]->holds_line(msg.address)) {
+        SIM_LOG("[VERIF-INTERCONNECT] PE " << msg.sender_id << " perdió la línea " << msg.address << " antes del UPGRADE, se atiende como WRITE_MISS");
+        stats_.pe(msg.sender_id).upgrade_fallbacks.fetch_add(1, memory_order_relaxed);
+        BusMessage miss = msg;
+        miss.type = WRITE_MISS;
+        return handle_cache_miss(miss);
     }
+
+    handle_invalidate(msg);
+    if (line_profiler_) line_profiler_->on_upgrade(msg.sender_id, msg.address);
+    mesi_controllers[msg.sender_id]->complete_upgrade(msg);
+    return InterconnectResponse{false, false};
 }
 
 
@@ -179,7 +809,93 @@ int Interconnect::get_bus_traffic() const {
     return bus_traffic;
 }
 
-void Interconnect::print_bus_state() const {
-    cout << "Trafico: " << bus_traffic << endl;
-    cout << "En cola: " << bus_queue.size() << endl;
+
+// Transacciones completadas por segundo entre la primera solicitud y la última respuesta
+double Interconnect::get_transactions_per_second() const {
+    uint64_t first = first_request_ns_.load(memory_order_relaxed);
+    uint64_t last = last_completion_ns_.load(memory_order_relaxed);
+    if (first == 0 || last <= first) return 0.0;
+    return completed_transactions_.load(memory_order_relaxed) * 1e9 / static_cast<double>(last - first);
+}
+
+// Valores globales del bus que acompañan la exportación de estadísticas
+SimStats::Summary Interconnect::stats_summary() const {
+    SimStats::Summary summary = {
+        {"num_pes", static_cast<double>(num_pes)},
+        {"bus_traffic", static_cast<double>(bus_traffic.load())},
+        {"snoop_messages", static_cast<double>(snoop_messages.load())},
+        {"snoop_filtered", static_cast<double>(get_filtered_snoops())},
+        {"completed_transactions", static_cast<double>(get_completed_transactions())},
+        {"transactions_per_second", get_transactions_per_second()},
+        {"directory_mode", mode_ == CoherenceMode::DIRECTORY ? 1.0 : 0.0},
+        {"split_bus", bus_mode_ == BusMode::SPLIT ? 1.0 : 0.0},
+        {"inline_bus", bus_mode_ == BusMode::INLINE ? 1.0 : 0.0},
+    };
+    const MemoryStats& mem = memory_.stats();
+    summary.push_back({"mem_reads", static_cast<double>(mem.reads.load())});
+    summary.push_back({"mem_writes", static_cast<double>(mem.writes.load())});
+    summary.push_back({"mem_dram_reads", static_cast<double>(mem.dram_reads.load())});
+    summary.push_back({"mem_dram_writes", static_cast<double>(mem.dram_writes.load())});
+    summary.push_back({"mem_row_hit_rate", mem.row_hit_rate()});
+    summary.push_back({"mem_write_buffer_hits", static_cast<double>(mem.write_buffer_hits.load())});
+    summary.push_back({"mem_coalesced_writes", static_cast<double>(mem.coalesced_writes.load())});
+    summary.push_back({"mem_read_mean_ns", mem.read_ns.mean()});
+    summary.push_back({"mem_queue_delay_mean_ns", mem.queue_delay_ns.mean()});
+    summary.push_back({"mem_queue_delay_p99_ns", static_cast<double>(mem.queue_delay_ns.percentile(99))});
+    if (topology_) {
+        const TopologyStats& topo = topology_->stats();
+        summary.push_back({"topo_clusters", static_cast<double>(topology_->num_clusters())});
+        summary.push_back({"topo_l2_hit_rate", topo.l2_hit_rate()});
+        summary.push_back({"topo_l2_evictions", static_cast<double>(topo.l2_evictions.load())});
+        summary.push_back({"topo_back_invalidations", static_cast<double>(topo.back_invalidations.load())});
+        summary.push_back({"topo_local_snoops", static_cast<double>(topo.local_snoops.load())});
+        summary.push_back({"topo_remote_probes", static_cast<double>(topo.remote_probes.load())});
+        summary.push_back({"topo_filtered_probes", static_cast<double>(topo.filtered_probes.load())});
+        summary.push_back({"topo_remote_memory_share", topo.remote_memory_share()});
+        summary.push_back({"topo_cross_node_messages", static_cast<double>(topo.cross_node_messages.load())});
+        summary.push_back({"topo_link_hops", static_cast<double>(topo.link_hops.load())});
+        summary.push_back({"topo_network_cycles", static_cast<double>(topo.network_cycles.load())});
+    }
+    summary.push_back({"num_banks", static_cast<double>(banks_.size())});
+    for (size_t i = 0; i < banks_.size(); ++i) {
+        string bank = "bank_" + to_string(i);
+        summary.push_back({bank + "_transactions", static_cast<double>(get_bank_transactions(i))});
+        summary.push_back({bank + "_utilization", get_bank_utilization(i)});
+    }
+    return summary;
+}
+
+
+// Tiempo de servicio del banco sobre el tiempo entre la primera solicitud y la última respuesta
+double Interconnect::get_bank_utilization(size_t bank) const {
+    uint64_t first = first_request_ns_.load(memory_order_relaxed);
+    uint64_t last = last_completion_ns_.load(memory_order_relaxed);
+    if (first == 0 || last <= first) return 0.0;
+    return banks_[bank]->busy_ns.load(memory_order_relaxed) / static_cast<double>(last - first);
+}
+
+
+// Exporta las estadísticas a JSON (y a CSV por PE si se indica ruta)
+bool Interconnect::export_stats(const string& json_path, const string& csv_path) const {
+    bool ok = stats_.export_json(json_path, stats_summary());
+    if (!csv_path.empty()) ok = stats_.export_csv(csv_path) && ok;
+    return ok;
+}
+
+
+void Interconnect::print_bus_state(ostream& os) const {
+    os << "Trafico: " << bus_traffic << endl;
+    size_t queued = 0;
+    for (const auto& bank : banks_) queued += bank->ring.size_approx();
+    os << "En cola: " << queued << " (" << banks_.size() << " bancos)" << endl;
+    os << "Memoria: " << memory_.stats().reads << " lecturas, aciertos de fila " << memory_.stats().row_hit_rate()
+       << ", espera media " << memory_.stats().queue_delay_ns.mean() << " ns" << endl;
+    os << "Consultas a PEs: " << snoop_messages << (mode_ == CoherenceMode::DIRECTORY ? " (directorio)" : " (snoop)");
+    if (mode_ == CoherenceMode::SNOOP) os << ", filtradas " << get_filtered_snoops();
+    os << endl;
+    if (topology_) {
+        os << "Clusters: " << topology_->num_clusters() << ", consultas remotas " << topology_->stats().remote_probes
+           << ", mensajes entre nodos " << topology_->stats().cross_node_messages << endl;
+    }
+    os << "Transacciones/s: " << get_transactions_per_second() << (bus_mode_ == BusMode::SPLIT ? " (split)" : bus_mode_ == BusMode::INLINE ? " (inline)" : " (atómico)") << endl;
 }
@@ -1,61 +1,250 @@
 #ifndef INTERCONNECT_H
 #define INTERCONNECT_H
 
+#include <atomic>
 #include <vector>
-#include <queue>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <iostream>
+#include <thread>
 
 #include "../cache/include/Cache.h"
 #include "../cache/include/memoria.h"
 #include "../PE/PE.h"
 #include "Interconnect/bus_types.h"
+#include "Interconnect/directory.h"
+#include "Interconnect/snoop_state_store.h"
+#include "Interconnect/mpsc_ring.h"
+#include "Interconnect/topology.h"
+#include "../Stats/sim_stats.h"
+#include "../Memory/memory_controller.h"
 
 using namespace std;
 
 // Hacer InterconnectResponse visible globalmente
+// La línea ya quedó instalada en la caché del solicitante (MESIController::install_line) dentro de la transacción
 struct InterconnectResponse {
-    array<double,4> linea;
-    bool from_memory;
+    bool from_memory;                                                                   // Ninguna caché entregó la línea
+    bool shared;                                                                        // Otra caché conserva una copia
+};
+
+// Modelo del bus: ATOMIC mantiene un único turno global (una transacción en vuelo);
+// SPLIT separa solicitud y respuesta y permite varias transacciones a bloques distintos.
+// INLINE no crea hilo árbitro: la transacción se ejecuta en el hilo que la pide. Es el modo del
+// motor de eventos discretos (Sim/event_engine.h), que ya serializa los accesos en un solo hilo.
+enum class BusMode {
+    ATOMIC,
+    SPLIT,
+    INLINE,
 };
 
 class MESIController;
+class TraceSink;
+class LineProfiler;
+enum class TraceEvent : uint8_t;
 
 class Interconnect {
 
 public:
-    Interconnect(int num_pes, Memoria* memoria, size_t queue_depth = 16);
+    // num_banks: rebanadas independientes del bus; el bloque de la dirección elige la rebanada.
+    // Con topology.pes_per_cluster > 0 los PEs se agrupan en clusters (ver topology.h).
+    Interconnect(int num_pes, Memoria* memoria, size_t queue_depth = 16, size_t num_banks = 1,
+                 CoherenceMode mode = CoherenceMode::SNOOP, BusMode bus_mode = BusMode::ATOMIC,
+                 const DramConfig& dram = DramConfig{}, const TopologyConfig& topology = TopologyConfig{});
+    ~Interconnect();
+
+    Interconnect(const Interconnect&) = delete;
+    Interconnect& operator=(const Interconnect&) = delete;
 
     // Configuración y gestión de PEs y controladores MESI
     void attach_mesi_controller(MESIController* mesi, int pe_id);
 
-    // Envío y procesamiento de mensajes del bus
-    void send_message(const BusMessage& msg);
+    // Envío y procesamiento de mensajes del bus. process_messages espera (y en SPLIT ejecuta) la
+    // transacción de la ranura msg.mshr; un PE con varios misses en vuelo usa wait_any_completion
+    // para atender primero la que ya esté lista.
+    // Una solicitud BusPriority::PREFETCH va a la cola de baja prioridad de su banco y nunca espera
+    // espacio: send_message retorna false si esa cola está llena y el mensaje no se envió.
+    bool send_message(const BusMessage& msg, BusPriority priority = BusPriority::DEMAND);
     optional<InterconnectResponse> process_messages(const BusMessage& msg);
+    uint8_t wait_any_completion(int pe_id, uint32_t mshr_mask);
+    uint32_t poll_completions(int pe_id, uint32_t mshr_mask);                           // Sin esperar: ranuras ya listas
+    double queue_occupancy(size_t address) const;                                       // Solicitudes esperando en el banco / queue_depth
+
+    // Llamado por un MESIController dentro de install_line (con su caché bloqueada): la víctima
+    // sucia llega a memoria antes de que otro snoop pueda ver que la línea ya no está en caché
+    void write_back_victim(int pe_id, size_t address, const array<double,4>& linea);
 
     // Estado y métricas del bus
     int get_bus_traffic() const;
-    void print_bus_state() const;
+    void print_bus_state(ostream& os = cout) const;
     size_t get_queue_depth() const { return queue_depth_; }
+    size_t get_num_banks() const { return banks_.size(); }
+    uint64_t get_bank_transactions(size_t bank) const { return banks_[bank]->transactions.load(memory_order_relaxed); }
+    double get_bank_utilization(size_t bank) const;                                     // Fracción del tiempo de corrida ocupada
+    int get_snoop_messages() const { return snoop_messages; }                           // Consultas enviadas a otros PEs
+    // SNOOP: consultas que un bus de difusión habría enviado y el SnoopStateStore evitó (con
+    // get_snoop_messages suman el costo de difundir cada transacción a todos los PEs)
+    uint64_t get_filtered_snoops() const { return filtered_snoops_.load(memory_order_relaxed); }
+    CoherenceMode get_coherence_mode() const { return mode_; }
+    BusMode get_bus_mode() const { return bus_mode_; }
+    uint64_t get_completed_transactions() const { return completed_transactions_.load(memory_order_relaxed); }
+    double get_transactions_per_second() const;
+
+    // Estadísticas por PE (ver Stats/sim_stats.h) y exportación al final de la corrida
+    SimStats& stats() { return stats_; }
+    const SimStats& stats() const { return stats_; }
+    SimStats::Summary stats_summary() const;
+    bool export_stats(const string& json_path, const string& csv_path = "") const;
+    void reset_stats();
+
+    // Contadores globales del bus que viajan en un checkpoint (ver Sim/checkpoint.h), un valor por banco
+    struct BusCounters {
+        uint64_t bus_traffic = 0;
+        uint64_t snoop_messages = 0;
+        uint64_t filtered_snoops = 0;
+        uint64_t completed_transactions = 0;
+        vector<uint64_t> bank_transactions;
+        vector<uint64_t> bank_busy_ns;
+    };
+    BusCounters bus_counters() const;
+    bool restore_bus_counters(const BusCounters& counters);                             // false si la cantidad de bancos no coincide
+
+    // Fast-forward funcional (calentamiento): sin bus, trazas ni tiempos; al salir se reinician los contadores
+    void begin_fast_forward();
+    void end_fast_forward();
+    bool fast_forward() const { return fast_forward_; }
+    Directory& directory() { return directory_; }
+
+    // Estado de todas las cachés para el snoop (ver snoop_state_store.h); lo escriben los controladores
+    SnoopStateStore& snoop_states() { return snoop_states_; }
+    const SnoopStateStore& snoop_states() const { return snoop_states_; }
+
+    // Memoria principal (ver Memory/memory_controller.h)
+    const MemoryController& memory() const { return memory_; }
+    void flush_memory();
+
+    // Topología jerárquica (ver topology.h); nullptr con el bus plano. fill_cluster_l2 trae el bloque a
+    // la L2 del cluster del PE (dentro de la transacción del bloque, o al restaurar un checkpoint).
+    const Topology* topology() const { return topology_.get(); }
+    void fill_cluster_l2(int pe_id, size_t address);
+    void clear_topology();
+    void set_sim_time(uint64_t ns);
+
+    // Trazas binarias (ver Trace/trace.h)
+    void set_trace_sink(TraceSink* sink);
+    TraceSink* trace_sink() const { return trace_sink_; }
+
+    // Perfil de contención por línea (ver Stats/line_profiler.h); nullptr lo desconecta
+    void set_line_profiler(LineProfiler* profiler) { line_profiler_ = profiler; }
+    LineProfiler* line_profiler() const { return line_profiler_; }
 
 private:
     Memoria *main_memory_;
+    MemoryController memory_;
+    uint64_t created_ns_;
+    atomic<uint64_t> sim_now_ns_{0};
+    atomic<bool> external_clock_{false};
 
-    int current_active_pe_id = -1;
     int num_pes;
     vector<MESIController*> mesi_controllers;
 
-    queue<BusMessage> bus_queue;
-
-    mutex bus_mutex;
-    condition_variable bus_cv;
-
-    int bus_traffic = 0;
+    atomic<int> bus_traffic{0};
+    atomic<int> snoop_messages{0};
+    atomic<uint64_t> filtered_snoops_{0};
+    int attached_pes_ = 0;
     size_t queue_depth_ = 16;
 
+    CoherenceMode mode_ = CoherenceMode::SNOOP;
+    BusMode bus_mode_ = BusMode::ATOMIC;
+    Directory directory_;
+    SnoopStateStore snoop_states_;
+    unique_ptr<Topology> topology_;
+
+    // Rebanada del bus: cola de solicitudes (productores: PEs, consumidor: su árbitro) y contadores.
+    // Cada bloque pertenece a un único banco, así la coherencia de una línea sigue serializada.
+    struct alignas(64) Bank {
+        explicit Bank(size_t depth) : ring(depth), low_ring(depth) {}
+        MpscRing<BusMessage> ring;
+        MpscRing<BusMessage> low_ring;                                                  // Prefetches: solo con ring vacía
+        thread arbiter;
+        atomic<uint64_t> transactions{0};
+        atomic<uint64_t> busy_ns{0};                                                    // Suma de tiempos de servicio
+    };
+    vector<unique_ptr<Bank>> banks_;
+
+    size_t bank_of(size_t address) const { return block_of(address) % banks_.size(); }
+
+    // Cada PE espera en su propio bloque de ranuras la respuesta (ATOMIC) o la concesión (SPLIT);
+    // hay una ranura por MSHR, así varios misses del mismo PE pueden estar en vuelo
+    struct alignas(64) CompletionSlot {
+        mutex m;
+        condition_variable cv;
+        uint32_t ready = 0;                                                             // Un bit por ranura
+        array<optional<InterconnectResponse>, REQUEST_SLOTS> result;
+        array<uint64_t, REQUEST_SLOTS> enqueue_ns{};                                    // Para el retardo en cola
+        uint32_t low_priority = 0;                                                      // Ranuras con un prefetch; solo el hilo del PE
+        uint32_t finished = 0;                                                          // SPLIT: el árbitro ya resolvió la transacción
+    };
+    unique_ptr<CompletionSlot[]> pe_slots_;
+
+    // Bus split: bloques con transacción en vuelo y solicitudes en espera
+    mutex split_mutex_;
+    list<BusMessage> pending_split_;                                                    // Solicitudes a la espera de su bloque o de capacidad
+    atomic<size_t> split_backlog_{0};                                                   // En vuelo + en espera, para queue_occupancy
+    vector<uint8_t> block_in_flight_;
+    size_t in_flight_ = 0;
+
+    atomic<uint64_t> completed_transactions_{0};
+    atomic<uint64_t> first_request_ns_{0};
+    atomic<uint64_t> last_completion_ns_{0};
+
+    SimStats stats_;
+
+    TraceSink* trace_sink_ = nullptr;
+    LineProfiler* line_profiler_ = nullptr;
+    ostream* log_stream_;                                                               // Bitácora del hilo que creó el sistema
+
+    bool fast_forward_ = false;                                                         // Solo cambia con el sistema detenido
+    TraceSink* saved_trace_sink_ = nullptr;
+    LineProfiler* saved_line_profiler_ = nullptr;
+
     InterconnectResponse handle_cache_miss(const BusMessage& msg);
     void handle_invalidate(const BusMessage& msg);
-    void handle_write_back(const BusMessage& msg);
+    InterconnectResponse handle_upgrade(const BusMessage& msg);
+    optional<InterconnectResponse> execute_transaction(const BusMessage& msg);
+
+    void arbiter_loop(Bank& bank);
+    void complete(const BusMessage& msg, optional<InterconnectResponse> result, bool finished = false);
+    optional<InterconnectResponse> wait_completion(const BusMessage& msg, bool* finished = nullptr);
+
+    void grant_split_request(const BusMessage& msg);
+    void run_split_prefetch(const BusMessage& msg);
+    optional<InterconnectResponse> process_split_response(const BusMessage& msg);
+    bool can_issue_split(const BusMessage& msg) const;
+    void issue_split(const BusMessage& msg);
+    void release_split(const BusMessage& msg);
+
+    optional<InterconnectResponse> process_inline(const BusMessage& msg);
+
+    uint64_t memory_time() const;
+    uint32_t read_memory(size_t address, array<double,4>& linea);                       // Latencia modelada en ns
+    void read_memory_cached(const BusMessage& msg, array<double,4>& linea, uint32_t probe_hops);
+    uint32_t write_memory(size_t address, const array<double,4>& linea);
+    void wait_memory(uint64_t start_ns) const;
+    void mark_first_request();
+    void record_completion(const BusMessage& msg, uint64_t grant_ns);
+    void update_directory(const BusMessage& msg, const optional<InterconnectResponse>& response);
+
+    template <typename F>
+    uint32_t for_each_snoop_target(const BusMessage& msg, F&& visit);
+    template <typename F>
+    void for_each_holder_target(const BusMessage& msg, F&& visit);
+    void count_filtered_snoops(uint32_t probes);
+    void drop_remote_l2(const BusMessage& msg);
+    void count_home_traffic(int pe_id, size_t address);
+    void trace(TraceEvent event, const BusMessage& msg, int target_pe = -1) const;
 };
 
 #endif // INTERCONNECT_H
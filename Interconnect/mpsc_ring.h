@@ -0,0 +1,164 @@
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+// Cola acotada sin locks de múltiples productores y un consumidor (esquema de Vyukov con
+// número de secuencia por ranura). La capacidad se redondea a potencia de dos.
+// push() aplica contrapresión: si la cola está llena el productor gira, cede el CPU y
+// finalmente se estaciona hasta que el consumidor libere una ranura; nunca descarta mensajes.
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacity) {
+        size_t pow2 = 1;
+        while (pow2 < capacity) pow2 <<= 1;
+        mask_ = pow2 - 1;
+        slots_ = make_unique<Slot[]>(pow2);
+        for (size_t i = 0; i < pow2; ++i) slots_[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    size_t size_approx() const {
+        size_t tail = tail_.load(memory_order_relaxed);
+        size_t head = head_.load(memory_order_relaxed);
+        return tail >= head ? tail - head : 0;
+    }
+
+    bool try_push(const T& item) {
+        size_t pos = tail_.load(memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & mask_];
+            size_t seq = slot.sequence.load(memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    slot.value = item;
+                    slot.sequence.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;                                                           // Llena
+            } else {
+                pos = tail_.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // Encola con contrapresión; retorna false solo si la cola fue cerrada
+    bool push(const T& item) {
+        for (int spin = 0; !try_push(item); ++spin) {
+            if (closed_.load(memory_order_acquire)) return false;
+            if (spin < 64) continue;
+            if (spin < 128) { this_thread::yield(); continue; }
+
+            unique_lock<mutex> lock(producer_mutex_);                                   // Estaciona hasta que haya espacio
+            parked_producers_.fetch_add(1, memory_order_seq_cst);
+            producer_cv_.wait_for(lock, chrono::milliseconds(1), [&] {
+                return size_approx() < capacity() || closed_.load(memory_order_acquire);
+            });
+            parked_producers_.fetch_sub(1, memory_order_relaxed);
+        }
+
+        atomic_thread_fence(memory_order_seq_cst);
+        if (consumer_parked_.load(memory_order_relaxed)) {
+            lock_guard<mutex> lock(consumer_mutex_);
+            consumer_cv_.notify_one();
+        }
+        return true;
+    }
+
+    // Solo el consumidor
+    bool try_pop(T& item) {
+        size_t pos = head_.load(memory_order_relaxed);
+        Slot& slot = slots_[pos & mask_];
+        size_t seq = slot.sequence.load(memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0) return false;  // Vacía
+
+        item = slot.value;
+        slot.sequence.store(pos + mask_ + 1, memory_order_release);
+        head_.store(pos + 1, memory_order_relaxed);
+
+        if (parked_producers_.load(memory_order_seq_cst) > 0) {
+            lock_guard<mutex> lock(producer_mutex_);
+            producer_cv_.notify_all();
+        }
+        return true;
+    }
+
+    // Espera un elemento; retorna false si la cola se cerró y quedó vacía
+    bool pop_wait(T& item) {
+        return pop_wait(item, [](T&) { return false; });
+    }
+
+    // Igual, pero cuando esta cola está vacía prueba fallback(item) (otra fuente de menor prioridad,
+    // que debe llamar wake_consumer() al recibir algo)
+    template <typename Fallback>
+    bool pop_wait(T& item, Fallback&& fallback) {
+        for (int spin = 0; spin < 64; ++spin) {
+            if (try_pop(item) || fallback(item)) return true;
+        }
+
+        unique_lock<mutex> lock(consumer_mutex_);
+        for (;;) {
+            consumer_parked_.store(true, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (try_pop(item) || fallback(item)) {
+                consumer_parked_.store(false, memory_order_relaxed);
+                return true;
+            }
+            if (closed_.load(memory_order_acquire)) {
+                consumer_parked_.store(false, memory_order_relaxed);
+                return false;
+            }
+            consumer_cv_.wait_for(lock, chrono::milliseconds(1));
+        }
+    }
+
+    // Despierta al consumidor estacionado (por ejemplo, llegó algo a su fuente de fallback)
+    void wake_consumer() {
+        atomic_thread_fence(memory_order_seq_cst);
+        if (consumer_parked_.load(memory_order_relaxed)) {
+            lock_guard<mutex> lock(consumer_mutex_);
+            consumer_cv_.notify_one();
+        }
+    }
+
+    void close() {
+        closed_.store(true, memory_order_release);
+        { lock_guard<mutex> lock(consumer_mutex_); consumer_cv_.notify_all(); }
+        { lock_guard<mutex> lock(producer_mutex_); producer_cv_.notify_all(); }
+    }
+
+private:
+    struct alignas(64) Slot {                                                           // Una ranura por línea de caché del host
+        atomic<size_t> sequence;
+        T value;
+    };
+
+    unique_ptr<Slot[]> slots_;
+    size_t mask_ = 0;
+
+    alignas(64) atomic<size_t> tail_{0};                                                // Productores
+    alignas(64) atomic<size_t> head_{0};                                                // Consumidor
+    alignas(64) atomic<bool> closed_{false};
+
+    mutex producer_mutex_;
+    condition_variable producer_cv_;
+    atomic<int> parked_producers_{0};
+
+    mutex consumer_mutex_;
+    condition_variable consumer_cv_;
+    atomic<bool> consumer_parked_{false};
+};
+
+#endif // MPSC_RING_H
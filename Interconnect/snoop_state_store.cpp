@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "snoop_state_store.h"
+
+using namespace std;
+
+static_assert(static_cast<uint8_t>(LineState::INVALID) == 0, "La máscara de poseedores compara contra 0");
+
+SnoopStateStore::SnoopStateStore(int num_pes)
+    : num_pes_(max(num_pes, 0)),
+      stride_((static_cast<size_t>(num_pes_) + CHUNK_PES - 1) / CHUNK_PES * CHUNK_PES) {
+    if (stride_ == 0) stride_ = CHUNK_PES;
+    size_t bytes = NUM_BLOCKS * stride_;
+    uint8_t* p = static_cast<uint8_t*>(aligned_alloc(64, bytes));                       // bytes es múltiplo de 64
+    if (!p) throw bad_alloc();
+    memset(p, 0, bytes);                                                                // Todo INVALID; el relleno queda en 0
+    states_.reset(p);
+}
+
+
+void SnoopStateStore::AlignedFree::operator()(uint8_t* p) const {
+    free(p);
+}
+
+
+// Una fila de CHUNK_PES bytes (una línea de caché del host) comparada contra INVALID
+uint64_t SnoopStateStore::holder_mask(size_t address, size_t first_pe) const {
+    const uint8_t* p = row(block_of(address)) + first_pe;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    uint32_t lo = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(p)), zero)));
+    uint32_t hi = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(p + 32)), zero)));
+    return ~(static_cast<uint64_t>(hi) << 32 | lo);
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t invalid = 0;
+    for (size_t i = 0; i < CHUNK_PES; i += 16) {
+        uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(p + i)), zero)));
+        invalid |= static_cast<uint64_t>(bits) << i;
+    }
+    return ~invalid;
+#else
+    return holder_mask_scalar(address, first_pe);
+#endif
+}
+
+
+uint64_t SnoopStateStore::holder_mask_scalar(size_t address, size_t first_pe) const {
+    const uint8_t* p = row(block_of(address)) + first_pe;
+    uint64_t mask = 0;
+    for (size_t i = 0; i < CHUNK_PES; ++i) {
+        if (p[i] != 0) mask |= uint64_t(1) << i;
+    }
+    return mask;
+}
+
+
+const char* SnoopStateStore::simd_name() {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,67 @@
+#ifndef SNOOP_STATE_STORE_H
+#define SNOOP_STATE_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "bus_types.h"
+#include "../MESI/coherence_protocol.h"
+
+using namespace std;
+
+// Copia, visible para el interconnect, del estado de coherencia de todas las cachés: un byte por
+// (bloque, PE), con los PEs de un bloque contiguos. Una comparación SIMD contra INVALID sobre la fila
+// del bloque da en una pasada la máscara de PEs que tienen la línea (AVX2, SSE2 o escalar según la
+// compilación), así el snoop solo consulta a esos PEs en lugar de a todos.
+//
+// La escribe cada MESIController al cambiar el estado de una línea. Es conservadora igual que el
+// Directory: un desalojo limpio silencioso deja al PE figurando hasta el próximo snoop, que lo corrige.
+// I -> válido solo ocurre dentro de la transacción del propio bloque, así nunca falta un poseedor.
+class SnoopStateStore {
+public:
+    static constexpr size_t CHUNK_PES = 64;                                             // PEs por máscara
+
+    explicit SnoopStateStore(int num_pes);
+
+    void set(size_t address, int pe_id, LineState state) {
+        __atomic_store_n(&row(block_of(address))[pe_id], static_cast<uint8_t>(state), __ATOMIC_RELAXED);
+    }
+    LineState get(size_t address, int pe_id) const {
+        return static_cast<LineState>(__atomic_load_n(&row(block_of(address))[pe_id], __ATOMIC_RELAXED));
+    }
+
+    // Bit i: el PE first_pe + i tiene la línea (first_pe múltiplo de CHUNK_PES)
+    uint64_t holder_mask(size_t address, size_t first_pe) const;
+    uint64_t holder_mask_scalar(size_t address, size_t first_pe) const;                 // Misma respuesta, sin SIMD
+
+    // Llama f(pe) por cada PE con la línea, en orden de PE, salvo exclude; f retorna true para detenerse
+    template <typename F>
+    void for_each_holder(size_t address, int exclude, F&& f) const {
+        for (size_t first = 0; first < static_cast<size_t>(num_pes_); first += CHUNK_PES) {
+            uint64_t mask = holder_mask(address, first);
+            while (mask) {
+                int pe = static_cast<int>(first + __builtin_ctzll(mask));
+                mask &= mask - 1;
+                if (pe != exclude && f(pe)) return;
+            }
+        }
+    }
+
+    int num_pes() const { return num_pes_; }
+    static const char* simd_name();                                                     // "avx2", "sse2" o "scalar"
+
+private:
+    struct AlignedFree {
+        void operator()(uint8_t* p) const;
+    };
+
+    int num_pes_;
+    size_t stride_;                                                                     // Bytes por bloque: PEs redondeados a CHUNK_PES
+    unique_ptr<uint8_t[], AlignedFree> states_;                                         // NUM_BLOCKS * stride_, alineado a 64
+
+    uint8_t* row(size_t block) { return states_.get() + block * stride_; }
+    const uint8_t* row(size_t block) const { return states_.get() + block * stride_; }
+};
+
+#endif // SNOOP_STATE_STORE_H
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "topology.h"
+
+using namespace std;
+
+const char* pe_placement_name(PePlacement placement) {
+    return placement == PePlacement::SCATTER ? "scatter" : "compact";
+}
+
+
+const char* node_layout_name(NodeLayout layout) {
+    return layout == NodeLayout::MESH ? "mesh" : "ring";
+}
+
+
+const char* home_policy_name(HomePolicy policy) {
+    return policy == HomePolicy::FIRST_TOUCH ? "first_touch" : "interleave";
+}
+
+
+void TopologyStats::reset() {
+    for (atomic<uint64_t>* counter : {&l2_hits, &l2_misses, &l2_evictions, &back_invalidations, &local_snoops,
+                                      &remote_probes, &filtered_probes, &local_memory, &remote_memory,
+                                      &cross_node_messages, &link_hops, &network_cycles}) {
+        counter->store(0, memory_order_relaxed);
+    }
+}
+
+
+Topology::Topology(const TopologyConfig& config, int num_pes) : config_(config) {
+    size_t pes = max(num_pes, 1);
+    config_.pes_per_cluster = max<size_t>(config_.pes_per_cluster, 1);
+    if ((pes + config_.pes_per_cluster - 1) / config_.pes_per_cluster > MAX_CLUSTERS) {
+        config_.pes_per_cluster = (pes + MAX_CLUSTERS - 1) / MAX_CLUSTERS;
+        cerr << "[Topology] Más de " << MAX_CLUSTERS << " clusters, se usan " << config_.pes_per_cluster
+             << " PEs por cluster" << endl;
+    }
+    size_t n = (pes + config_.pes_per_cluster - 1) / config_.pes_per_cluster;
+
+    pe_cluster_.resize(pes);
+    for (size_t pe = 0; pe < pes; ++pe) {
+        pe_cluster_[pe] = static_cast<int>(config_.placement == PePlacement::SCATTER ? pe % n : pe / config_.pes_per_cluster);
+    }
+
+    size_t width = max<size_t>(static_cast<size_t>(ceil(sqrt(static_cast<double>(n)))), 1);
+    distance_.resize(n * n);
+    for (size_t a = 0; a < n; ++a) {
+        for (size_t b = 0; b < n; ++b) {
+            size_t d;
+            if (config_.layout == NodeLayout::MESH) {
+                d = max(a % width, b % width) - min(a % width, b % width) + max(a / width, b / width) - min(a / width, b / width);
+            } else {
+                d = max(a, b) - min(a, b);
+                d = min(d, n - d);
+            }
+            distance_[a * n + b] = static_cast<uint32_t>(d);
+        }
+    }
+
+    config_.l2_ways = max<size_t>(config_.l2_ways, 1);
+    sets_ = max<size_t>(config_.l2_lines / config_.l2_ways, 1);
+    config_.l2_lines = sets_ * config_.l2_ways;
+    for (size_t c = 0; c < n; ++c) {
+        auto l2 = make_unique<ClusterL2>();
+        l2->tags.assign(config_.l2_lines, -1);
+        l2->lru.assign(config_.l2_lines, 0);
+        clusters_.push_back(move(l2));
+    }
+
+    config_.home_lines = max<size_t>(config_.home_lines, 1);
+    regions_ = (NUM_BLOCKS + config_.home_lines - 1) / config_.home_lines;
+    first_touch_ = make_unique<atomic<int8_t>[]>(regions_);
+    for (size_t r = 0; r < regions_; ++r) first_touch_[r].store(-1, memory_order_relaxed);
+}
+
+
+int Topology::home_of(size_t address, int requester_cluster) {
+    size_t region = block_of(address) / config_.home_lines;
+    if (config_.home == HomePolicy::INTERLEAVE) return static_cast<int>(region % clusters_.size());
+
+    int8_t home = first_touch_[region].load(memory_order_relaxed);
+    if (home < 0 && first_touch_[region].compare_exchange_strong(home, static_cast<int8_t>(requester_cluster), memory_order_relaxed)) {
+        return requester_cluster;
+    }
+    return home;                                                                        // compare_exchange dejó el home ganador
+}
+
+
+// ==================================================================================== L2 DEL CLUSTER ===
+
+
+bool Topology::l2_contains(int cluster, size_t address) const {
+    const ClusterL2& l2 = *clusters_[cluster];
+    int32_t block = static_cast<int32_t>(block_of(address));
+    size_t begin = set_begin(block);
+    lock_guard<mutex> lock(l2.m);
+    for (size_t way = begin; way < begin + config_.l2_ways; ++way) {
+        if (l2.tags[way] == block) return true;
+    }
+    return find(l2.evicting.begin(), l2.evicting.end(), block) != l2.evicting.end();
+}
+
+
+bool Topology::l2_lookup(int cluster, size_t address) {
+    ClusterL2& l2 = *clusters_[cluster];
+    int32_t block = static_cast<int32_t>(block_of(address));
+    size_t begin = set_begin(block);
+    lock_guard<mutex> lock(l2.m);
+    for (size_t way = begin; way < begin + config_.l2_ways; ++way) {
+        if (l2.tags[way] == block) {
+            l2.lru[way] = ++l2.tick;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// Trae el bloque a la L2 (LRU dentro del conjunto). La víctima queda en evicting hasta
+// l2_finish_eviction: quien llama debe invalidarla antes en las L1 del cluster.
+optional<size_t> Topology::l2_fill(int cluster, size_t address) {
+    ClusterL2& l2 = *clusters_[cluster];
+    int32_t block = static_cast<int32_t>(block_of(address));
+    size_t begin = set_begin(block);
+    lock_guard<mutex> lock(l2.m);
+
+    size_t chosen = begin;
+    for (size_t way = begin; way < begin + config_.l2_ways; ++way) {
+        if (l2.tags[way] == block) {
+            l2.lru[way] = ++l2.tick;
+            return nullopt;
+        }
+        if (l2.tags[chosen] >= 0 && (l2.tags[way] < 0 || l2.lru[way] < l2.lru[chosen])) chosen = way;
+    }
+
+    int32_t victim = l2.tags[chosen];
+    l2.tags[chosen] = block;
+    l2.lru[chosen] = ++l2.tick;
+    if (victim < 0) return nullopt;
+    l2.evicting.push_back(victim);
+    stats_.l2_evictions.fetch_add(1, memory_order_relaxed);
+    return static_cast<size_t>(victim) * WORDS_PER_LINE;
+}
+
+
+void Topology::l2_finish_eviction(int cluster, size_t address) {
+    ClusterL2& l2 = *clusters_[cluster];
+    int32_t block = static_cast<int32_t>(block_of(address));
+    lock_guard<mutex> lock(l2.m);
+    auto it = find(l2.evicting.begin(), l2.evicting.end(), block);
+    if (it != l2.evicting.end()) l2.evicting.erase(it);
+}
+
+
+void Topology::l2_drop(int cluster, size_t address) {
+    ClusterL2& l2 = *clusters_[cluster];
+    int32_t block = static_cast<int32_t>(block_of(address));
+    size_t begin = set_begin(block);
+    lock_guard<mutex> lock(l2.m);
+    for (size_t way = begin; way < begin + config_.l2_ways; ++way) {
+        if (l2.tags[way] == block) l2.tags[way] = -1;
+    }
+}
+
+
+// Vacía las L2 y olvida los homes de FIRST_TOUCH (restaurar un checkpoint)
+void Topology::clear() {
+    for (auto& l2 : clusters_) {
+        lock_guard<mutex> lock(l2->m);
+        fill(l2->tags.begin(), l2->tags.end(), -1);
+        l2->evicting.clear();
+    }
+    for (size_t r = 0; r < regions_; ++r) first_touch_[r].store(-1, memory_order_relaxed);
+}
+
+
+void Topology::count_messages(int from, int to, uint64_t messages) {
+    if (from == to || messages == 0) return;
+    stats_.cross_node_messages.fetch_add(messages, memory_order_relaxed);
+    stats_.link_hops.fetch_add(messages * hops(from, to), memory_order_relaxed);
+}
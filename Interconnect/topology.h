@@ -0,0 +1,142 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "bus_types.h"
+
+using namespace std;
+
+// Cómo se reparten los PEs entre clusters: COMPACT pone PEs consecutivos en el mismo cluster,
+// SCATTER los reparte en ronda (PE i en el cluster i % clusters)
+enum class PePlacement : uint8_t {
+    COMPACT,
+    SCATTER,
+};
+
+// Disposición de los nodos en la red entre clusters
+enum class NodeLayout : uint8_t {
+    RING,                                                                               // Anillo bidireccional
+    MESH,                                                                               // Malla 2D, distancia Manhattan
+};
+
+// Nodo dueño (home) de cada región de memoria
+enum class HomePolicy : uint8_t {
+    INTERLEAVE,                                                                         // Regiones repartidas en ronda entre nodos
+    FIRST_TOUCH,                                                                        // El nodo del primer PE que la lee de memoria
+};
+
+const char* pe_placement_name(PePlacement placement);
+const char* node_layout_name(NodeLayout layout);
+const char* home_policy_name(HomePolicy policy);
+
+
+// Topología jerárquica. Con pes_per_cluster = 0 el sistema es el bus plano de siempre.
+// Latencias en ciclos (las suma el motor de eventos, ver Sim/event_engine.h).
+struct TopologyConfig {
+    size_t pes_per_cluster = 0;
+    PePlacement placement = PePlacement::COMPACT;
+    NodeLayout layout = NodeLayout::RING;
+    HomePolicy home = HomePolicy::INTERLEAVE;
+    size_t home_lines = 64;                                                             // Líneas por región de memoria con el mismo home
+    size_t l2_lines = 256;                                                              // L2 compartida de cada cluster
+    size_t l2_ways = 8;
+    uint32_t l2_cycles = 12;                                                            // Consulta a la L2 en cada miss de L1
+    uint32_t hop_cycles = 30;                                                           // Un salto entre nodos vecinos, por sentido
+};
+
+
+// Contadores de la topología; mensajes entre nodos contados por sentido (solicitud y respuesta)
+struct TopologyStats {
+    atomic<uint64_t> l2_hits{0};                                                        // Misses sin proveedor servidos por la L2 del cluster
+    atomic<uint64_t> l2_misses{0};                                                      // Misses sin proveedor que fueron a memoria
+    atomic<uint64_t> l2_evictions{0};
+    atomic<uint64_t> back_invalidations{0};                                             // Líneas de L1 invalidadas por desalojos de la L2
+    atomic<uint64_t> local_snoops{0};                                                   // Consultas a PEs del cluster del solicitante
+    atomic<uint64_t> remote_probes{0};                                                  // Consultas a la L2 de otro cluster
+    atomic<uint64_t> filtered_probes{0};                                                // Clusters que un broadcast plano habría consultado
+    atomic<uint64_t> local_memory{0};                                                   // Lecturas de memoria del propio nodo
+    atomic<uint64_t> remote_memory{0};
+    atomic<uint64_t> cross_node_messages{0};
+    atomic<uint64_t> link_hops{0};                                                      // Saltos recorridos por esos mensajes
+    atomic<uint64_t> network_cycles{0};                                                 // L2 + red, suma por transacción
+
+    void reset();
+    double l2_hit_rate() const {
+        uint64_t n = l2_hits + l2_misses;
+        return n ? static_cast<double>(l2_hits) / n : 0.0;
+    }
+    double remote_memory_share() const {
+        uint64_t n = local_memory + remote_memory;
+        return n ? static_cast<double>(remote_memory) / n : 0.0;
+    }
+};
+
+
+// PEs agrupados en clusters; cada cluster es un nodo con una L2 compartida e inclusiva y la memoria de
+// las regiones de las que es home. La L2 guarda solo etiquetas: sus datos serían los de memoria, porque
+// una línea sucia siempre la entrega primero su L1 dueña (M/O) y los write-backs van a memoria.
+// Al ser inclusiva, un cluster cuya L2 no tiene el bloque no tiene copias en sus L1 y no se le consulta.
+//
+// Las operaciones de L2 toman el mutex de su cluster, nunca con la caché de un PE bloqueada.
+// Un bloque desalojado de la L2 sigue figurando (evicting) hasta que el interconnect terminó de
+// invalidarlo en las L1 del cluster, así un snoop concurrente no lo filtra antes de tiempo.
+class Topology {
+public:
+    static constexpr size_t MAX_CLUSTERS = 64;                                          // Máscara de clusters consultados
+
+    Topology(const TopologyConfig& config, int num_pes);
+
+    const TopologyConfig& config() const { return config_; }
+    size_t num_clusters() const { return clusters_.size(); }
+    int cluster_of(int pe_id) const { return pe_cluster_[pe_id]; }
+    uint32_t hops(int from, int to) const { return distance_[from * clusters_.size() + to]; }
+    int home_of(size_t address, int requester_cluster);                                 // FIRST_TOUCH: el solicitante la reclama
+
+    // L2 del cluster
+    bool l2_contains(int cluster, size_t address) const;
+    bool l2_lookup(int cluster, size_t address);                                        // Acierto: actualiza LRU
+    optional<size_t> l2_fill(int cluster, size_t address);                              // Devuelve la víctima (en evicting)
+    void l2_finish_eviction(int cluster, size_t address);
+    void l2_drop(int cluster, size_t address);                                          // Sin copias en el cluster: solo la etiqueta
+    void clear();
+
+    // Contabilidad de mensajes entre nodos y del tiempo de red de una transacción: la consulta a la L2
+    // más ida y vuelta hasta el nodo más lejano involucrado (hops saltos)
+    void count_messages(int from, int to, uint64_t messages);
+    void charge_transaction(uint32_t hops) {
+        stats_.network_cycles.fetch_add(config_.l2_cycles + 2ull * config_.hop_cycles * hops, memory_order_relaxed);
+    }
+
+    TopologyStats& stats() { return stats_; }
+    const TopologyStats& stats() const { return stats_; }
+
+private:
+    struct alignas(64) ClusterL2 {
+        mutable mutex m;
+        vector<int32_t> tags;                                                           // Bloque por vía, -1 libre
+        vector<uint64_t> lru;
+        vector<int32_t> evicting;
+        uint64_t tick = 0;
+    };
+
+    TopologyConfig config_;
+    size_t sets_;
+    vector<int> pe_cluster_;
+    vector<uint32_t> distance_;                                                         // Saltos entre cada par de nodos
+    vector<unique_ptr<ClusterL2>> clusters_;
+    unique_ptr<atomic<int8_t>[]> first_touch_;                                          // Home de cada región, -1 sin asignar
+    size_t regions_;
+
+    TopologyStats stats_;
+
+    size_t set_begin(size_t block) const { return (block % sets_) * config_.l2_ways; }
+};
+
+#endif // TOPOLOGY_H
@@ -1,209 +1,688 @@
+#include <algorithm>
 #include <iostream>
 
 #include "MESIController.h"
 #include "../Interconnect/bus_types.h"
 #include "../Interconnect/interconnect.h"
+#include "../Stats/line_profiler.h"
+#include "../Trace/trace.h"
 
 using namespace std;
 
-MESIController::MESIController(Cache* cache, Interconnect* interconnect, int pe_id)
-    : cache_(cache), interconnect_(interconnect), pe_id_(pe_id) {}
+MESIController::MESIController(Cache* cache, Interconnect* interconnect, int pe_id, size_t num_mshrs, ProtocolKind protocol)
+    : protocol_(protocol), cache_(cache), interconnect_(interconnect), pe_id_(pe_id), line_states_(NUM_BLOCKS, LineState::INVALID),
+      mshrs_(min(max<size_t>(num_mshrs, 1), MAX_MSHRS)), prefetched_(NUM_BLOCKS, 0) {
+    if (interconnect_ && pe_id_ >= 0 && pe_id_ < interconnect_->stats().num_pes()) {
+        stats_ = &interconnect_->stats().pe(pe_id_);
+        snoop_states_ = &interconnect_->snoop_states();
+    }
+}
 
-// ==================================================================================== METODOS PRINCIPALES ===
 
+MESIController* make_mesi_controller(ProtocolKind protocol, Cache* cache, Interconnect* interconnect, int pe_id,
+                                     size_t num_mshrs) {
+    return new MESIController(cache, interconnect, pe_id, num_mshrs, protocol);
+}
 
-// Lee un dato de la caché, si no está, envía mensaje de read miss al interconnect para obtenerlo
-optional<double> MESIController::read(uint16_t address) { 
-    
-    auto result = cache_->read_data_linea_cache(address);                               // Intenta leer de caché privada
 
-    if (result.has_value()) {                                                           // Si está en caché lo retorna, sino envia solicitud al bus
-        cout << "[VERIF-MESI] PE " << pe_id_ << " hit en caché privada para dirección " << address << endl;
-        return result;                                                                  // Retorna el dato leído
-    } else {
-        cout << "[VERIF-MESI] PE " << pe_id_ << " miss en caché privada para dirección " << address << endl;
-        return request_line_from_bus(address, READ_MISS, 0.0, MESIState::SHARED);       // Solicita línea al bus
+const char* MESIController::protocol_name() const {
+    switch (protocol_) {
+        case ProtocolKind::MOESI: return MoesiProtocol::name;
+        case ProtocolKind::MESIF: return MesifProtocol::name;
+        case ProtocolKind::MESI:
+        default: return MesiProtocol::name;
     }
 }
 
+// ==================================================================================== METODOS PRINCIPALES ===
+
+
+// Lee un dato de la caché, si no está, envía mensaje de read miss al interconnect y espera la línea
+optional<double> MESIController::read(uint16_t address) { 
+    return run_access(MshrTarget{address, AccessOp::READ, 0.0, 0.0, nullptr});
+}
 
-// Escribe un dato en la caché, si no está, envía mensaje de write miss al interconnect para obtenerlo
+
+// Escribe un dato en la caché y espera a que la escritura quede hecha (ver issue_access)
 void MESIController::write(uint16_t address, double value) {
+    run_access(MshrTarget{address, AccessOp::WRITE, value, 0.0, nullptr});
+}
 
-    auto result = cache_->write_data_linea_cache(address, value);                       // Intenta escribir en caché privada
-    
-    if (result.has_value()) {                                                           // Si está en caché lo escribe directamente, sino envia solicitud al bus
-        cout << "[VERIF-MESI] PE " << pe_id_ << " escribió dato en caché privada para dirección " << address << endl;
-        cache_->update_linea_cache_mesi(address, MESIState::MODIFIED);                  // Actualiza estado a MODIFIED
-        cout << "[VERIF-MESI] PE " << pe_id_ << " actualizó estado de línea (a MODIFIED). Enviando invalidación a otros PEs..." << endl;
-        send_invalidate_to_others(address);                                             // Notifica a otros PEs para invalidar la línea
-        cout << "[VERIF-MESI] PE " << pe_id_ << " finalizó flujo de invalidación directa para dirección " << address << endl;
-    } else {
-        cout << "[VERIF-MESI] PE " << pe_id_ << " MISS al escribir en caché para dirección " << address << endl;
-        request_line_from_bus(address, WRITE_MISS, value, MESIState::MODIFIED);         // Solicita línea al bus
-    }
+
+void MESIController::read_async(uint16_t address, optional<double>* dest) {
+    bool trigger = false;
+    issue_access(MshrTarget{address, AccessOp::READ, 0.0, 0.0, dest}, trigger);
+    issue_prefetches(address, trigger);
+}
+
+
+void MESIController::write_async(uint16_t address, double value) {
+    bool trigger = false;
+    issue_access(MshrTarget{address, AccessOp::WRITE, value, 0.0, nullptr}, trigger);
+    issue_prefetches(address, trigger);
+}
+
+
+void MESIController::drain() {
+    while (outstanding_mask_) retire_any();
+}
+
+
+optional<double> MESIController::fetch_add(uint16_t address, double delta) {
+    return run_atomic(MshrTarget{address, AccessOp::FETCH_ADD, delta, 0.0, nullptr});
+}
+
+
+optional<double> MESIController::exchange(uint16_t address, double value) {
+    return run_atomic(MshrTarget{address, AccessOp::EXCHANGE, value, 0.0, nullptr});
+}
+
+
+optional<double> MESIController::compare_and_swap(uint16_t address, double expected, double desired) {
+    return run_atomic(MshrTarget{address, AccessOp::COMPARE_SWAP, desired, expected, nullptr});
+}
+
+
+optional<double> MESIController::load_linked(uint16_t address) {
+    return run_atomic(MshrTarget{address, AccessOp::LOAD_LINKED, 0.0, 0.0, nullptr});
+}
+
+
+bool MESIController::store_conditional(uint16_t address, double value) {
+    optional<double> stored = run_atomic(MshrTarget{address, AccessOp::STORE_CONDITIONAL, value, 0.0, nullptr});
+    return stored.value_or(0.0) != 0.0;
 }
 
 
 // ==================================================================================== FUNCIONES AUXILIARES ===
 
 
-// Maneja la solicitud de una línea al interconnect para READ_MISS y WRITE_MISS
-optional<double> MESIController::request_line_from_bus(uint16_t address, MessageType type, double value, MESIState new_state) {
-    
+// Acceso bloqueante: espera solo su propio miss y devuelve lo que deja en dest
+optional<double> MESIController::run_access(MshrTarget access) {
+    optional<double> result;
+    access.dest = &result;
+    bool trigger = false;
+    int mshr = issue_access(access, trigger);
+    if (mshr >= 0) retire_mshr(mshr);
+    issue_prefetches(access.address, trigger);
+    return result;
+}
+
+
+// Las atómicas son barreras: ningún acceso anterior del PE queda en vuelo (tampoco un prefetch al
+// bloque, así el enlace de LL/SC solo cambia por el acceso mismo o por snoops)
+optional<double> MESIController::run_atomic(MshrTarget access) {
+    if (!interconnect_) return nullopt;
+    drain();
+    return run_access(access);
+}
+
+
+// Atiende un acceso del PE. Devuelve el MSHR que lo lleva, o -1 si ya quedó hecho (hit).
+// Un bloque con MSHR en vuelo recibe el acceso como destino extra (también los hits sobre una línea
+// con UPGRADE pendiente, así una lectura ve las escrituras anteriores del propio PE). Una escritura
+// no se fusiona con un READ_MISS: espera a que termine y se atiende de nuevo.
+// Escritura: en E/M escribe sin usar el bus (E -> M silencioso); en S/O/F pide UPGRADE para
+// invalidar a los demás sin traer la línea; si no está, envía WRITE_MISS. Las atómicas siguen el mismo
+// camino que una escritura; un store_conditional sin enlace falla sin usar el bus.
+// trigger queda en true si el acceso debe disparar al prefetcher: fue miss o usó por primera vez una
+// línea traída por prefetch.
+int MESIController::issue_access(const MshrTarget& access, bool& trigger) {
+    uint16_t address = access.address;
+    bool write = writes(access.op);
+    MessageType access_type = access.op == AccessOp::READ ? READ : access.op == AccessOp::WRITE ? WRITE : RMW;
     if (!interconnect_) {                                                               // Verifica que el interconnect esté disponible
-        cout << "[VERIF-MESI] ERROR: No hay interconnect disponible para PE " << pe_id_ << endl;
-        return nullopt;
+        SIM_LOG("[VERIF-MESI] ERROR: No hay interconnect disponible para PE " << pe_id_);
+        return -1;
     }
 
+    while (prefetch_mask_ && retire_prefetch()) {}                                      // Libera los prefetches que ya terminaron
+
+    size_t block = block_of(address);
+    bool stalled = false;
+    while (true) {
+        int busy = -1;                                                                  // MSHR del bloque que hay que esperar
+        int allocated = -1;
+        MessageType type = READ_MISS;
+        {
+            lock_guard<mutex> lock(cache_mutex_);
+
+            int index = find_mshr(block);
+            if (index >= 0) {
+                Mshr& mshr = mshrs_[index];
+                if (!mshr.filled && mshr.num_targets < MAX_MSHR_TARGETS && !(write && mshr.type == READ_MISS)) {
+                    mshr.targets[mshr.num_targets++] = access;
+                    SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " fusiona acceso a dirección " << address << " en el MSHR " << index);
+                    bool hit = mshr.type == UPGRADE;                                    // La línea ya está en caché
+                    trace(hit ? TraceEvent::ACCESS_HIT : TraceEvent::ACCESS_MISS, address, access_type);
+                    if (write) count(hit ? &PeStats::write_hits : &PeStats::write_misses);
+                    else count(hit ? &PeStats::read_hits : &PeStats::read_misses);
+                    count(&PeStats::mshr_merges);
+                    if (mshr.prefetch) {                                                // La demanda alcanzó a un prefetch en vuelo
+                        mshr.prefetch = false;
+                        count(&PeStats::prefetch_late);
+                    }
+                    trigger = !hit;
+                    return index;
+                }
+                busy = index;
+            } else if (!write) {
+                optional<double> result = cache_->read_data_linea_cache(address);       // Intenta leer de caché privada
+                if (result.has_value()) {
+                    SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " hit en caché privada para dirección " << address);
+                    trace(TraceEvent::ACCESS_HIT, address, access_type);
+                    count(&PeStats::read_hits);
+                    trigger = consume_prefetched(address);
+                    if (access.op == AccessOp::LOAD_LINKED) link_block_ = static_cast<int64_t>(block);
+                    if (access.dest) *access.dest = result;
+                    return -1;
+                }
+                type = READ_MISS;
+            } else {
+                LineState state = line_state(address);
+                if (state != LineState::INVALID && !cache_->read_linea_cache(address).has_value()) {
+                    store_state(address, LineState::INVALID);                           // La caché la desalojó limpia, sin avisar
+                    state = LineState::INVALID;
+                }
+                if (access.op == AccessOp::STORE_CONDITIONAL) {
+                    count(&PeStats::store_conditionals);
+                    if (link_block_ != static_cast<int64_t>(block)) {                   // Enlace perdido: falla sin usar el bus
+                        SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " store_conditional sin enlace para dirección " << address);
+                        trace(TraceEvent::ACCESS_HIT, address, RMW);
+                        count(&PeStats::sc_failures);
+                        if (access.dest) *access.dest = 0.0;
+                        return -1;
+                    }
+                }
+                if (state == LineState::EXCLUSIVE || state == LineState::MODIFIED) {   // Única copia: escribe directamente
+                    apply_access(access);
+                    set_line_state(address, LineState::MODIFIED, access_type);
+                    SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " escribió dato en caché privada para dirección " << address << " sin usar el bus");
+                    trace(TraceEvent::ACCESS_HIT, address, access_type);
+                    count(&PeStats::write_hits);
+                    if (state == LineState::EXCLUSIVE) count(&PeStats::silent_upgrades);
+                    trigger = consume_prefetched(address);
+                    return -1;
+                }
+                type = state != LineState::INVALID ? UPGRADE : WRITE_MISS;              // Hay otras copias: solo hace falta invalidarlas
+            }
+
+            if (busy < 0 && (allocated = free_mshr()) >= 0) {
+                Mshr& mshr = mshrs_[allocated];
+                mshr.valid = true;
+                mshr.filled = false;
+                mshr.prefetch = false;
+                mshr.type = type;
+                mshr.address = address;
+                mshr.num_targets = 1;
+                mshr.targets[0] = access;
+                if (type == UPGRADE) {
+                    trigger = consume_prefetched(address);
+                } else {
+                    prefetched_[block] = 0;                                             // Una línea marcada se desalojó sin usarse
+                    trigger = true;
+                }
+            }
+        }
+
+        if (allocated >= 0) {
+            if (type == UPGRADE) {
+                SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " tiene la línea en " << line_state_name(line_state(address)) << ", enviando UPGRADE para dirección " << address);
+                trace(TraceEvent::ACCESS_HIT, address, access_type);
+                count(&PeStats::write_hits);
+            } else {
+                SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " miss en caché privada para dirección " << address << " (" << message_type_name(type) << ")");
+                trace(TraceEvent::ACCESS_MISS, address, access_type);
+                count(write ? &PeStats::write_misses : &PeStats::read_misses);
+            }
+            send_mshr(allocated);                                                       // Solicita línea al bus
+            return allocated;
+        }
+
+        if (busy >= 0) {
+            retire_mshr(busy);
+        } else {
+            if (!stalled) count(&PeStats::mshr_full_stalls);                            // Todos los MSHRs ocupados
+            stalled = true;
+            retire_any();
+        }
+    }
+}
+
+
+// MSHR en uso para el bloque, o -1 (requiere cache_mutex_)
+int MESIController::find_mshr(size_t block) const {
+    for (size_t i = 0; i < mshrs_.size(); ++i) {
+        if (mshrs_[i].valid && block_of(mshrs_[i].address) == block) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+
+int MESIController::free_mshr() const {
+    for (size_t i = 0; i < mshrs_.size(); ++i) {
+        if (!mshrs_[i].valid) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+
+// Envía la solicitud del MSHR; la respuesta llega a su ranura del interconnect. Solo un prefetch
+// puede no enviarse (cola de baja prioridad llena): queda sin marcar en vuelo.
+bool MESIController::send_mshr(int index, BusPriority priority) {
     BusMessage msg;                                                                     // Prepara el mensaje para el interconnect
     msg.sender_id = pe_id_;
-    msg.type = type;
-    msg.address = address;
-    msg.data = value;
+    msg.type = mshrs_[index].type;
+    msg.address = mshrs_[index].address;
+    msg.mshr = static_cast<uint8_t>(index);
+
+    outstanding_mask_ |= 1u << index;
+    if (priority == BusPriority::PREFETCH) prefetch_mask_ |= 1u << index;
+    if (interconnect_->send_message(msg, priority)) return true;                        // Envía el mensaje al interconnect
+
+    outstanding_mask_ &= ~(1u << index);
+    prefetch_mask_ &= ~(1u << index);
+    return false;
+}
+
+
+// Espera hasta que el MSHR termine. Mientras tanto atiende los otros misses que ya estén listos
+// (en SPLIT el PE ejecuta su fase de respuesta, así ninguna concesión queda retenida).
+void MESIController::retire_mshr(int index) {
+    while (outstanding_mask_ & (1u << index)) retire_any();
+}
+
+
+void MESIController::retire_any() {
+    retire_slot(interconnect_->wait_any_completion(pe_id_, outstanding_mask_));
+}
 
-    interconnect_->send_message(msg);                                                   // Envía el mensaje al interconnect
+
+optional<uint16_t> MESIController::retire_prefetch() {
+    int index = ready_prefetch();
+    if (index < 0) return nullopt;
+    uint16_t address = mshrs_[index].address;
+    retire_slot(static_cast<uint8_t>(index));
+    return address;
+}
+
+
+optional<uint16_t> MESIController::next_prefetch() {
+    int index = ready_prefetch();
+    if (index < 0) return nullopt;
+    return mshrs_[index].address;
+}
+
+
+// Primer MSHR de prefetch con la ranura lista, o -1
+int MESIController::ready_prefetch() {
+    uint32_t pending = outstanding_mask_ & prefetch_mask_;
+    uint32_t ready = pending ? interconnect_->poll_completions(pe_id_, pending) : 0;
+    return ready ? __builtin_ctz(ready) : -1;
+}
+
+
+// Procesa la respuesta (o en SPLIT la concesión) de un MSHR cuya ranura ya está lista y lo libera.
+// Un prefetch puede volver sin línea (el bus SPLIT lo descartó): si una demanda se le fusionó
+// mientras tanto, el MSHR se reenvía como solicitud normal y sigue en vuelo.
+void MESIController::retire_slot(uint8_t index) {
+    BusMessage msg;
+    msg.sender_id = pe_id_;
+    msg.type = mshrs_[index].type;
+    msg.address = mshrs_[index].address;
+    msg.mshr = index;
     auto interconnect_response = interconnect_->process_messages(msg);                  // Procesa el mensaje y espera la respuesta
 
-    if (interconnect_response.has_value()) {                                            // Si recibió una línea válida
+    bool prefetch = (prefetch_mask_ >> index) & 1u;
+    if (!interconnect_response.has_value() && !prefetch) {
+        SIM_LOG("[VERIF-MESI] ERROR: PE " << pe_id_ << " no recibió línea válida para dirección " << msg.address);
+    }
+
+    if (prefetch && !interconnect_response.has_value() && mshrs_[index].num_targets > 0) {  // Solo el hilo del PE agrega destinos
+        prefetch_mask_ &= ~(1u << index);
+        send_mshr(index);
+        return;
+    }
+
+    lock_guard<mutex> lock(cache_mutex_);
+    mshrs_[index].valid = false;
+    outstanding_mask_ &= ~(1u << index);
+    prefetch_mask_ &= ~(1u << index);
+}
 
-        const auto& response = interconnect_response.value();                           // Extrae la respuesta
-        cout << "[VERIF-MESI] PE " << pe_id_ << " recibió línea para dirección " << address << " y la escribe en caché" << endl;
 
-        auto write_back_line = cache_->write_linea_cache(address, const_cast<array<double,4>&>(response.linea)); // Escribe la línea en caché
-        
-        MESIState next_state;                                                           // Determina el siguiente estado de la línea
-        if (type == READ_MISS) {                                                        // Si es READ_MISS
-            if (response.from_memory) {                                                 // Si vino de memoria principal, pasa a EXCLUSIVE, sino a SHARED porque vino de otro caché
-                next_state = MESIState::EXCLUSIVE;
-            } else {    
-                next_state = MESIState::SHARED;
+// Entrena al prefetcher con el acceso y pide las líneas que proponga, salteando las que ya están en
+// caché o en un MSHR. Se detiene sin MSHR de sobra; un banco congestionado solo descarta lo suyo.
+// En fast-forward solo entrena: nada puede quedar en vuelo al volver al modo detallado.
+void MESIController::issue_prefetches(uint16_t address, bool trigger) {
+    if (!prefetcher_ || !interconnect_) return;
+    prefetch_candidates_.clear();
+    prefetcher_->observe(address, trigger, prefetch_candidates_);
+    if (interconnect_->fast_forward()) return;
+
+    double threshold = prefetcher_->config().congestion_threshold;
+    for (uint16_t candidate : prefetch_candidates_) {
+        int allocated = -1;
+        {
+            lock_guard<mutex> lock(cache_mutex_);
+            size_t block = block_of(candidate);
+            if (find_mshr(block) >= 0) continue;
+            if (line_states_[block] != LineState::INVALID) {
+                if (cache_->read_linea_cache(candidate).has_value()) continue;
+                store_state(candidate, LineState::INVALID);                             // Desalojo limpio silencioso
             }
-        } else if (type == WRITE_MISS) {                                                // Si es WRITE_MISS, pasa a MODIFIED
-            next_state = MESIState::MODIFIED;
+
+            size_t free = 0;
+            for (const Mshr& mshr : mshrs_) free += !mshr.valid;
+            if (free < 2) {                                                             // El último MSHR queda para la demanda
+                count(&PeStats::prefetch_throttled);
+                return;
+            }
+            if (interconnect_->queue_occupancy(candidate) >= threshold) {
+                count(&PeStats::prefetch_throttled);
+                continue;
+            }
+
+            allocated = free_mshr();
+            Mshr& mshr = mshrs_[allocated];
+            mshr.valid = true;
+            mshr.filled = false;
+            mshr.prefetch = true;
+            mshr.type = READ_MISS;
+            mshr.address = candidate;
+            mshr.num_targets = 0;
         }
-        
-        cache_->update_linea_cache_mesi(address, next_state);                           // Actualiza el estado de la línea en caché
 
-        if (write_back_line.has_value()) {                                              // Si hubo write-back, envia el mensaje al interconnect
-            cout << "[VERIF-MESI] PE " << pe_id_ << " genera WRITE_BACK para dirección " << write_back_line->direccion_bloque << endl;
-            request_write_back(write_back_line->direccion_bloque, write_back_line->linea_cache);
+        if (!send_mshr(allocated, BusPriority::PREFETCH)) {
+            lock_guard<mutex> lock(cache_mutex_);
+            mshrs_[allocated].valid = false;
+            count(&PeStats::prefetch_throttled);
+            continue;
         }
+        SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " pide por prefetch la dirección " << candidate << " (MSHR " << allocated << ")");
+        count(&PeStats::prefetch_issued);
+    }
+}
 
-        if (type == WRITE_MISS) {                                                       // Si es WRITE_MISS, escribe el dato solicitado, sino lee y retorna
-            cache_->write_data_linea_cache(address, value);                             // Escribe el dato solicitado
-            return nullopt;                                                             // Este es ignorado por write
-        } else {
-            auto final_result = cache_->read_data_linea_cache(address);                 // Lee el dato solicitado 
-            if (final_result.has_value()) {                                             // Si pudo leer el dato
-                cout << "[VERIF-MESI] PE " << pe_id_ << " accedió al dato tras recibir línea para dirección " << address << endl;
-                return final_result;                                                    // Retorna el dato leído
+
+// Primer uso de una línea traída por prefetch: cuenta el prefetch como útil (requiere cache_mutex_)
+bool MESIController::consume_prefetched(size_t address) {
+    uint8_t& flag = prefetched_[block_of(address)];
+    if (!flag) return false;
+    flag = 0;
+    count(&PeStats::prefetch_useful);
+    return true;
+}
+
+
+// Aplica un acceso sobre la línea en caché, en MODIFIED si escribe (requiere cache_mutex_). La lectura
+// y la escritura de una atómica ocurren sin soltar el lock: ningún snoop puede intercalarse.
+void MESIController::apply_access(const MshrTarget& access) {
+    switch (access.op) {
+        case AccessOp::READ:
+        case AccessOp::LOAD_LINKED:
+            if (access.op == AccessOp::LOAD_LINKED) link_block_ = static_cast<int64_t>(block_of(access.address));
+            if (access.dest) *access.dest = cache_->read_data_linea_cache(access.address);  // Lee el dato solicitado
+            return;
+        case AccessOp::WRITE:
+            cache_->write_data_linea_cache(access.address, access.value);               // Escribe el dato solicitado
+            profile_write(access.address);
+            return;
+        case AccessOp::STORE_CONDITIONAL: {                                             // El enlace pudo perderse con el miss en vuelo
+            bool linked = link_block_ == static_cast<int64_t>(block_of(access.address));
+            link_block_ = -1;
+            if (linked) {
+                cache_->write_data_linea_cache(access.address, access.value);
+                profile_write(access.address);
             } else {
-                cout << "[VERIF-MESI] ERROR: PE " << pe_id_ << " no pudo acceder al dato tras recibir línea para dirección " << address << endl;
-                return nullopt;                                                         
+                count(&PeStats::sc_failures);
             }
+            if (access.dest) *access.dest = linked ? 1.0 : 0.0;
+            return;
         }
+        default:
+            break;
+    }
+
+    double previous = cache_->read_data_linea_cache(access.address).value_or(0.0);
+    double next = access.op == AccessOp::FETCH_ADD ? previous + access.value : access.value;
+    count(&PeStats::atomic_rmws);
+    if (access.op != AccessOp::COMPARE_SWAP || previous == access.expected) {
+        cache_->write_data_linea_cache(access.address, next);
+        profile_write(access.address);
     } else {
-        cout << "[VERIF-MESI] ERROR: PE " << pe_id_ << " no recibió línea válida para dirección " << address << endl;
-        return nullopt;
+        count(&PeStats::cas_failures);
     }
+    if (access.dest) *access.dest = previous;
 }
 
 
-// Maneja el envío de un mensaje WRITE_BACK al interconnect (parametros correctos en el mensaje para write_bloque?)
-void MESIController::request_write_back(uint16_t address, const array<double,4>& linea_cache) {
-    if (!interconnect_) {                                                               // Verifica que el interconnect esté disponible
-        cout << "[VERIF-MESI] ERROR: No hay interconnect disponible para PE " << pe_id_ << endl;
-        return;
+// Atiende en orden los accesos que esperaban la línea del MSHR (requiere cache_mutex_)
+void MESIController::apply_targets(Mshr& mshr) {
+    for (size_t i = 0; i < mshr.num_targets; ++i) apply_access(mshr.targets[i]);
+    mshr.filled = true;
+}
+
+
+// Instala la línea recibida del bus con la política del controlador
+void MESIController::install_line(const BusMessage& msg, array<double,4>& linea, bool shared) {
+    switch (protocol_) {
+        case ProtocolKind::MOESI: return install_line_as<MoesiProtocol>(msg, linea, shared);
+        case ProtocolKind::MESIF: return install_line_as<MesifProtocol>(msg, linea, shared);
+        case ProtocolKind::MESI:
+        default: return install_line_as<MesiProtocol>(msg, linea, shared);
     }
+}
 
-    BusMessage msg;                                                                     // Prepara el mensaje para el interconnect
-    msg.sender_id = pe_id_;
-    msg.type = WRITE_BACK;
-    msg.address = address;
-    msg.cache_line = linea_cache;                                                       // Adjunta la línea de caché para write-back
-    interconnect_->send_message(msg);                                                   // Envía el mensaje al interconnect
-    interconnect_->process_messages(msg);                                               // Procesa el mensaje
-}
-
-
-// Maneja el envío de un mensaje INVALIDATE a los otros PEs a través del interconnect
-void MESIController::send_invalidate_to_others(uint16_t address) {
-    if (interconnect_) {                                                                // Verifica que el interconnect esté disponible
-        
-        cout << "[VERIF-MESI] PE " << pe_id_ << " envía mensaje INVALIDATE al interconnect para dirección " << address << endl;
-        
-        BusMessage msg;                                                                 // Prepara el mensaje para el interconnect
-        msg.sender_id = pe_id_;
-        msg.type = INVALIDATE;
-        msg.address = address;
-        interconnect_->send_message(msg);                                               // Envía el mensaje al interconnect
-        interconnect_->process_messages(msg);                                           // Procesa el mensaje
-        
-        cout << "[VERIF-MESI] PE " << pe_id_ << " mensaje INVALIDATE enviado al interconnect para dirección " << address << endl;
-    } else {
-        cout << "[VERIF-MESI] ERROR: No hay interconnect disponible para PE " << pe_id_ << endl;
+
+// Instala la línea recibida del bus, fija el estado según el protocolo y atiende los accesos del MSHR.
+// La víctima sucia se escribe en memoria antes de soltar la caché y antes de publicarla como INVALID
+// en el SnoopStateStore: un snoop concurrente a ese bloque (otro banco) que la filtra ya encuentra el
+// dato en memoria, y uno que todavía la ve espera cache_mutex_ y tampoco la encuentra en caché.
+template <class Protocol>
+void MESIController::install_line_as(const BusMessage& msg, array<double,4>& linea, bool shared) {
+    lock_guard<mutex> lock(cache_mutex_);
+
+    SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " recibió línea para dirección " << msg.address << " y la escribe en caché");
+    auto write_back_line = cache_->write_linea_cache(msg.address, linea);               // Escribe la línea recibida en caché
+
+    LineState next_state = (msg.type == WRITE_MISS) ? LineState::MODIFIED : Protocol::read_fill[shared];
+    set_line_state(msg.address, next_state, msg.type);                                  // Actualiza el estado de la línea en caché
+
+    if (msg.mshr < mshrs_.size() && mshrs_[msg.mshr].valid) {
+        if (mshrs_[msg.mshr].prefetch) prefetched_[block_of(msg.address)] = 1;         // Sin demanda aún: se marca hasta su primer uso
+        apply_targets(mshrs_[msg.mshr]);
+    }
+
+    if (!write_back_line.has_value()) return;
+
+    SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " genera WRITE_BACK para dirección " << write_back_line->direccion_bloque);
+    interconnect_->write_back_victim(pe_id_, write_back_line->direccion_bloque, write_back_line->linea_cache);
+    store_state(write_back_line->direccion_bloque, LineState::INVALID);                 // La víctima deja la caché
+}
+
+
+// La línea deja la caché porque la L2 del cluster la desalojó; si estaba sucia llega a memoria antes de
+// soltar la caché, igual que una víctima de install_line
+bool MESIController::back_invalidate(size_t address) {
+    lock_guard<mutex> lock(cache_mutex_);
+    LineState state = line_state(address);
+    if (state == LineState::INVALID) return false;
+    auto line = cache_->read_linea_cache(address);
+    if (!line.has_value()) {
+        store_state(address, LineState::INVALID);                                       // Desalojo limpio silencioso
+        return false;
     }
+
+    SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " invalida la línea " << address << " por desalojo de la L2 del cluster");
+    if (state == LineState::MODIFIED || state == LineState::OWNED) interconnect_->write_back_victim(pe_id_, address, *line);
+    set_line_state(address, LineState::INVALID, INVALIDATE);
+    return true;
+}
+
+
+// Contenido de la línea si la caché todavía la tiene
+optional<array<double,4>> MESIController::line_data(size_t address) {
+    lock_guard<mutex> lock(cache_mutex_);
+    if (line_state(address) == LineState::INVALID) return nullopt;
+    auto line = cache_->read_linea_cache(address);
+    if (!line.has_value()) store_state(address, LineState::INVALID);                    // Desalojo limpio silencioso
+    return line;
+}
+
+
+// Instala una línea de un checkpoint sin pasar por el bus ni dejar trazas
+void MESIController::restore_line(size_t address, LineState state, const array<double,4>& linea) {
+    lock_guard<mutex> lock(cache_mutex_);
+    array<double,4> copia = linea;
+    auto write_back_line = cache_->write_linea_cache(address, copia);
+    store_state(address, state);
+    cache_->update_linea_cache_mesi(address, to_cache_state(state));
+
+    if (!write_back_line.has_value()) return;                                           // Checkpoint de una caché más grande
+    if (interconnect_) interconnect_->write_back_victim(pe_id_, write_back_line->direccion_bloque, write_back_line->linea_cache);
+    store_state(write_back_line->direccion_bloque, LineState::INVALID);
+}
+
+
+// Vacía la caché antes de restaurar un checkpoint (las líneas sucias se descartan: el checkpoint trae la memoria)
+void MESIController::invalidate_all() {
+    lock_guard<mutex> lock(cache_mutex_);
+    for (size_t block = 0; block < NUM_BLOCKS; ++block) {
+        if (line_states_[block] == LineState::INVALID) continue;
+        size_t address = block * WORDS_PER_LINE;
+        store_state(address, LineState::INVALID);
+        cache_->update_linea_cache_mesi(address, MESIState::INVALID);
+    }
+}
+
+
+bool MESIController::holds_line(size_t address) {
+    lock_guard<mutex> lock(cache_mutex_);
+    if (line_state(address) == LineState::INVALID) return false;
+    if (cache_->read_linea_cache(address).has_value()) return true;
+    store_state(address, LineState::INVALID);                                           // Desalojo limpio silencioso
+    return false;
+}
+
+
+// Las demás copias ya se invalidaron: pasa a MODIFIED y atiende los accesos del MSHR
+void MESIController::complete_upgrade(const BusMessage& msg) {
+    lock_guard<mutex> lock(cache_mutex_);
+    set_line_state(msg.address, LineState::MODIFIED, UPGRADE);
+    if (msg.mshr < mshrs_.size() && mshrs_[msg.mshr].valid) apply_targets(mshrs_[msg.mshr]);
+}
+
+
+// Cambia el estado real de la línea y lo proyecta a la caché (requiere cache_mutex_)
+void MESIController::set_line_state(size_t address, LineState next, MessageType cause) {
+    LineState current = line_state(address);
+    if (current == next) return;
+    if (next == LineState::INVALID && prefetched_[block_of(address)]) count(&PeStats::prefetch_invalidated);
+
+    trace(TraceEvent::STATE_CHANGE, address, cause, static_cast<uint8_t>(current), static_cast<uint8_t>(next));
+    store_state(address, next);
+    cache_->update_linea_cache_mesi(address, to_cache_state(next));
+}
+
+
+// Estado real de la línea y su copia en el SnoopStateStore del interconnect (requiere cache_mutex_)
+void MESIController::store_state(size_t address, LineState next) {
+    line_states_[block_of(address)] = next;
+    if (next == LineState::INVALID) {
+        prefetched_[block_of(address)] = 0;
+        if (link_block_ == static_cast<int64_t>(block_of(address))) link_block_ = -1;  // Invalidación o desalojo: se pierde el enlace
+    }
+    if (snoop_states_) snoop_states_->set(address, pe_id_, next);
+}
+
+
+void MESIController::profile_write(uint16_t address) {
+    if (LineProfiler* profiler = interconnect_->line_profiler()) profiler->on_write(pe_id_, address);
+}
+
+
+// Registro binario de un evento del controlador; desaparece si el nivel de traza compilado es OFF
+void MESIController::trace(TraceEvent event, uint16_t address, MessageType type, uint8_t from_state, uint8_t to_state) const {
+    trace_event(interconnect_ ? interconnect_->trace_sink() : nullptr, event, pe_id_, -1, address,
+                static_cast<uint8_t>(type), from_state, to_state);
 }
 
 
 // ==================================================================================== PARA MENSAJES DEL EXTERIOR ===
 
 
-// Procesa un mensaje recibido del bus (Interconnect) y retorna la línea si la tiene
-optional<array<double,4>> MESIController::process_bus_message(const BusMessage& msg) {
+// Procesa un mensaje recibido del bus (Interconnect); si entrega la línea la escribe en line_out
+SnoopReply MESIController::process_bus_message(const BusMessage& msg, array<double,4>* line_out) {
     switch (msg.type) {
         case READ_MISS:
-            return handle_cache_miss_bus(msg);                                          // Maneja READ_MISS
+            return handle_cache_miss_bus(msg, line_out);                                // Maneja READ_MISS
         case WRITE_MISS:
-            return handle_cache_miss_bus(msg);                                          // Maneja WRITE_MISS
+            return handle_cache_miss_bus(msg, line_out);                                // Maneja WRITE_MISS
         case INVALIDATE:
-            handle_invalidate_bus(msg);                                                 // Maneja INVALIDATE
-            break;
+        case UPGRADE:
+            return handle_invalidate_bus(msg);                                          // Maneja INVALIDATE y UPGRADE
         default: {
-            cerr << "[VERIF-MESI] PE " << pe_id_ << " recibió mensaje desconocido tipo " << msg.type << endl;
-            return nullopt;
+            cerr << "[VERIF-MESI] PE " << pe_id_ << " recibió mensaje desconocido tipo " << message_type_name(msg.type) << endl;
+            return SnoopReply{};
         }
     }
-    return nullopt;
 }
 
 
-// Maneja el mensaje de cache miss (READ_MISS o WRITE_MISS) recibido del bus
-optional<array<double,4>> MESIController::handle_cache_miss_bus(const BusMessage& msg) {
-    
-    auto line = cache_->read_linea_cache(msg.address);                                  // Verifica si tiene la línea en caché
-    
-    if (line.has_value()) {
-        if (msg.type == READ_MISS) {                                                    // Si es READ_MISS
-            cout << "[VERIF-MESI] PE " << pe_id_ << " tiene línea en caché para dirección " << msg.address << " (READ_MISS), actualizando estado a SHARED y devolviendo línea..." << endl;
-            //cache_->update_linea_cache_mesi(msg.address, MESIState::SHARED);            // Actualiza estado a SHARED
-        } else if (msg.type == WRITE_MISS) {
-            cout << "[VERIF-MESI] PE " << pe_id_ << " tiene línea en caché para dirección " << msg.address << " (WRITE_MISS), invalidando y devolviendo línea..." << endl;
-            //cache_->update_linea_cache_mesi(msg.address, MESIState::INVALID);           // Actualiza estado a INVALID
-        }
-        return line;                                                                    // Retorna la línea encontrada en caché
-    } else {
-        cout << "[VERIF-MESI] PE " << pe_id_ << " NO tiene línea en caché para dirección " << msg.address << " (MISS)" << endl;
-        return nullopt;                                                             
+// Maneja el mensaje de cache miss (READ_MISS o WRITE_MISS) recibido del bus según la tabla del protocolo
+SnoopReply MESIController::handle_cache_miss_bus(const BusMessage& msg, array<double,4>* line_out) {
+    switch (protocol_) {
+        case ProtocolKind::MOESI: return snoop_miss<MoesiProtocol>(msg, line_out);
+        case ProtocolKind::MESIF: return snoop_miss<MesifProtocol>(msg, line_out);
+        case ProtocolKind::MESI:
+        default: return snoop_miss<MesiProtocol>(msg, line_out);
     }
 }
 
 
-// Maneja el mensaje INVALIDATE recibido del bus
-void MESIController::handle_invalidate_bus(const BusMessage& msg) {
-    cout << "[VERIF-MESI] PE " << pe_id_ << " recibe mensaje INVALIDATE desde bus para dirección " << msg.address << " (solicitado por PE " << msg.sender_id << ")" << endl;
+template <class Protocol>
+SnoopReply MESIController::snoop_miss(const BusMessage& msg, array<double,4>* line_out) {
+    lock_guard<mutex> lock(cache_mutex_);
+
     auto line = cache_->read_linea_cache(msg.address);                                  // Verifica si tiene la línea en caché
     
-    if (line.has_value()) {
-        cout << "[VERIF-MESI] PE " << pe_id_ << " tiene línea en caché para dirección " << msg.address << ", invalidando (cambiando estado a INVALID, si se descomenta)..." << endl;
-        //cache_->update_linea_cache_mesi(msg.address, MESIState::INVALID);               // Invalida la línea en caché
-    } else {
-        cout << "[VERIF-MESI] PE " << pe_id_ << " NO tiene línea en caché para dirección " << msg.address << ", nada que invalidar." << endl;
+    if (!line.has_value()) {
+        SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " NO tiene línea en caché para dirección " << msg.address << " (MISS)");
+        store_state(msg.address, LineState::INVALID);                                   // Pudo desalojarse en silencio
+        return SnoopReply{};
     }
-}
-
-
 
+    size_t current = static_cast<size_t>(line_state(msg.address));
+    const SnoopAction& action = msg.type == READ_MISS ? Protocol::snoop_read[current] : Protocol::snoop_write[current];
+    SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " tiene línea en caché para dirección " << msg.address << " (" << message_type_name(msg.type)
+            << "), " << line_state_name(line_state(msg.address)) << " -> " << line_state_name(action.next)
+            << (action.supplies ? ", devolviendo línea..." : ", sin responder datos"));
+
+    SnoopReply reply;
+    reply.had_line = true;
+    if (action.supplies && line_out) {
+        *line_out = *line;                                                              // Entrega la línea directo en el destino del interconnect
+        reply.supplied = true;
+        reply.flush = action.flush;
+    }
+    set_line_state(msg.address, action.next, msg.type);
+    return reply;
+}
 
 
+// Maneja el mensaje INVALIDATE recibido del bus
+SnoopReply MESIController::handle_invalidate_bus(const BusMessage& msg) {
+    SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " recibe mensaje INVALIDATE desde bus para dirección " << msg.address << " (solicitado por PE " << msg.sender_id << ")");
+    lock_guard<mutex> lock(cache_mutex_);
+
+    SnoopReply reply;
+    if (line_state(msg.address) != LineState::INVALID) {
+        SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " tiene línea en caché para dirección " << msg.address << ", invalidando...");
+        reply.had_line = true;
+        set_line_state(msg.address, LineState::INVALID, msg.type);                      // Invalida la línea en caché
+    } else {
+        SIM_LOG("[VERIF-MESI] PE " << pe_id_ << " NO tiene línea en caché para dirección " << msg.address << ", nada que invalidar.");
+    }
+    return reply;
+}
@@ -1,38 +1,195 @@
 #ifndef MESI_CONTROLLER_H
 #define MESI_CONTROLLER_H
 
+#include <array>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 #include "../cache/include/Cache.h"
 #include "../Interconnect/bus_types.h"
 #include "../Interconnect/interconnect.h"
+#include "../Trace/trace.h"
+#include "coherence_protocol.h"
+#include "prefetcher.h"
 
 using namespace std;
 
 // Forward declaration para evitar dependencias circulares
 class Interconnect;
 
+constexpr size_t DEFAULT_MSHRS = 8;
+
+// Controlador de coherencia de un PE. El protocolo (MESI/coherence_protocol.h) se elige en tiempo de
+// ejecución al construirlo. La instalación de una línea y la reacción a un snoop de miss se instancian
+// por política y leen sus tablas constexpr directamente; install_line y handle_cache_miss_bus eligen la
+// instancia con un switch sobre protocol_, que no cambia durante la vida del PE. No hay funciones virtuales.
+//
+// Cada miss (READ_MISS, WRITE_MISS o UPGRADE) ocupa un MSHR hasta que su transacción termina. Un
+// acceso a un bloque que ya tiene MSHR no genera otra solicitud: se agrega como destino del MSHR y
+// se atiende, en orden, al instalar la línea. read/write esperan su propio miss; read_async y
+// write_async dejan el miss en vuelo y solo esperan si no queda MSHR libre.
+//
+// Con un Prefetcher (ver MESI/prefetcher.h) cada acceso de demanda lo entrena y las líneas que propone
+// se piden como READ_MISS de baja prioridad en un MSHR propio, sin destinos. Un prefetch nunca toma el
+// último MSHR libre (hacen falta al menos 2) y no se pide si la cola del banco pasa el umbral de
+// congestión. Las líneas traídas quedan marcadas hasta su primer uso para contar prefetches útiles,
+// tardíos (la demanda llegó con el prefetch en vuelo) e invalidados antes de usarse.
+//
+// Operaciones atómicas (fetch_add, exchange, compare_and_swap, store_conditional): piden la línea como
+// una escritura (UPGRADE o WRITE_MISS) y hacen la lectura y la escritura en caché bajo cache_mutex_ con
+// la línea en MODIFIED, así que ningún snoop se intercala entre ambas. En un miss el RMW se aplica al
+// instalar la línea, dentro de la transacción del PE, antes de que el banco atienda a otro. Como las
+// instrucciones LOCK de x86 son además barreras: esperan antes los misses en vuelo del PE.
 class MESIController {
 public:
-	MESIController(Cache* cache, Interconnect* interconnect, int pe_id);
+	MESIController(Cache* cache, Interconnect* interconnect, int pe_id, size_t num_mshrs = DEFAULT_MSHRS,
+	               ProtocolKind protocol = ProtocolKind::MESI);
 
 	optional<double> read(uint16_t address);
 	void write(uint16_t address, double value);
-	optional<array<double,4>> process_bus_message(const BusMessage& msg);
 
-	optional<array<double,4>> handle_cache_miss_bus(const BusMessage& msg);
-	void handle_invalidate_bus(const BusMessage& msg);
-	optional<double> request_line_from_bus(uint16_t address, MessageType type, double value, MESIState new_state);
-	void request_write_back(uint16_t address, const array<double,4>& linea_cache);
-	void send_invalidate_to_others(uint16_t address);
+	// Accesos no bloqueantes (solo desde el hilo del PE). El dato leído llega a *dest al instalarse
+	// la línea y es válido después de drain().
+	void read_async(uint16_t address, optional<double>* dest = nullptr);
+	void write_async(uint16_t address, double value);
+	void drain();                                                                       // Espera todos los misses en vuelo
+
+	// Devuelven el valor anterior; compare_and_swap escribe desired solo si ese valor es expected
+	optional<double> fetch_add(uint16_t address, double delta);
+	optional<double> exchange(uint16_t address, double value);
+	optional<double> compare_and_swap(uint16_t address, double expected, double desired);
+	// LL/SC: load_linked lee y enlaza el bloque. store_conditional escribe solo si el enlace sigue vigente,
+	// es decir si la línea no se invalidó (escritura de otro PE o desalojo) desde el load_linked.
+	optional<double> load_linked(uint16_t address);
+	bool store_conditional(uint16_t address, double value);
+	void set_prefetcher(unique_ptr<Prefetcher> prefetcher) { prefetcher_ = move(prefetcher); }
+	const Prefetcher* prefetcher() const { return prefetcher_.get(); }
+	// Procesa un prefetch en vuelo cuya respuesta ya llegó (en INLINE lo ejecuta) y devuelve su dirección.
+	// Los accesos lo hacen solos; el motor de eventos lo llama para medir cada prefetch por separado.
+	// next_prefetch dice, sin procesarlo, cuál atendería retire_prefetch.
+	optional<uint16_t> retire_prefetch();
+	optional<uint16_t> next_prefetch();
+	size_t outstanding_misses() const { return __builtin_popcount(outstanding_mask_); }
+	size_t num_mshrs() const { return mshrs_.size(); }
+
+	SnoopReply process_bus_message(const BusMessage& msg, array<double,4>* line_out = nullptr);
+
+	SnoopReply handle_cache_miss_bus(const BusMessage& msg, array<double,4>* line_out);
+	SnoopReply handle_invalidate_bus(const BusMessage& msg);
+
+	// Llamado por el interconnect dentro de la transacción UPGRADE del propio PE
+	bool holds_line(size_t address);
+	void complete_upgrade(const BusMessage& msg);
+
+	// Llamado por el interconnect dentro de la transacción del propio PE: instala la línea recibida
+	void install_line(const BusMessage& msg, array<double,4>& linea, bool shared);
+
+	// Desalojo de la L2 inclusiva del cluster (ver Interconnect/topology.h); true si tenía la línea
+	bool back_invalidate(size_t address);
+
+	// Checkpoint (ver Sim/checkpoint.h): solo con el sistema detenido y sin misses en vuelo
+	optional<array<double,4>> line_data(size_t address);
+	void restore_line(size_t address, LineState state, const array<double,4>& linea);
+	void invalidate_all();
+
+	LineState line_state(size_t address) const { return line_states_[block_of(address)]; }
+	int get_pe_id() const { return pe_id_; }
+	ProtocolKind protocol() const { return protocol_; }
+	const char* protocol_name() const;
 
 private:
+	ProtocolKind protocol_;
 	Cache* cache_;
 	Interconnect* interconnect_;
 	int pe_id_;
+	PeStats* stats_ = nullptr;
+	SnoopStateStore* snoop_states_ = nullptr;
+
+	mutex cache_mutex_;                                                                 // Accesos locales vs. snoops del bus
+	vector<LineState> line_states_;                                                     // Estado real por bloque (incluye O y F)
+
+	enum class AccessOp : uint8_t {
+		READ,
+		WRITE,
+		FETCH_ADD,
+		EXCHANGE,
+		COMPARE_SWAP,
+		LOAD_LINKED,
+		STORE_CONDITIONAL,
+	};
+
+	// Escriben: necesitan la línea en MODIFIED
+	static bool writes(AccessOp op) { return op != AccessOp::READ && op != AccessOp::LOAD_LINKED; }
+
+	// Acceso del PE; queda como destino de un MSHR mientras espera la línea
+	struct MshrTarget {
+		uint16_t address;
+		AccessOp op;
+		double value;                                                                   // Dato a escribir o a sumar (FETCH_ADD)
+		double expected;                                                                // COMPARE_SWAP
+		optional<double>* dest;                                                         // Dato leído o anterior; SC: 1 si escribió (puede ser nullptr)
+	};
+	static constexpr size_t MAX_MSHR_TARGETS = 8;
+
+	struct Mshr {
+		bool valid = false;
+		bool filled = false;                                                            // La transacción ya atendió los destinos
+		bool prefetch = false;                                                          // Pedido por el prefetcher y sin demanda aún
+		MessageType type = READ_MISS;
+		uint16_t address = 0;
+		uint8_t num_targets = 0;
+		array<MshrTarget, MAX_MSHR_TARGETS> targets;
+	};
+	vector<Mshr> mshrs_;                                                                // Contenido protegido por cache_mutex_ (install_line corre en el árbitro)
+	uint32_t outstanding_mask_ = 0;                                                     // MSHRs con transacción enviada; solo el hilo del PE
+	uint32_t prefetch_mask_ = 0;                                                        // De ellos, los enviados como prefetch
+
+	unique_ptr<Prefetcher> prefetcher_;
+	vector<uint8_t> prefetched_;                                                        // Por bloque: traído por prefetch y sin usar (cache_mutex_)
+	vector<uint16_t> prefetch_candidates_;
+
+	int64_t link_block_ = -1;                                                           // Bloque enlazado por load_linked (cache_mutex_)
+
+	optional<double> run_access(MshrTarget access);
+	optional<double> run_atomic(MshrTarget access);
+	int issue_access(const MshrTarget& access, bool& trigger);
+	int find_mshr(size_t block) const;
+	int free_mshr() const;
+	bool send_mshr(int index, BusPriority priority = BusPriority::DEMAND);
+	void retire_mshr(int index);
+	void retire_any();
+	void retire_slot(uint8_t index);
+	int ready_prefetch();
+	void apply_access(const MshrTarget& access);
+	void apply_targets(Mshr& mshr);
+
+	template <class Protocol>
+	SnoopReply snoop_miss(const BusMessage& msg, array<double,4>* line_out);
+	template <class Protocol>
+	void install_line_as(const BusMessage& msg, array<double,4>& linea, bool shared);
+
+	void issue_prefetches(uint16_t address, bool trigger);
+	bool consume_prefetched(size_t address);
+
+	void set_line_state(size_t address, LineState next, MessageType cause);
+	void store_state(size_t address, LineState next);
+
+	void count(atomic<uint64_t> PeStats::* counter) {
+		if (stats_) (stats_->*counter).fetch_add(1, memory_order_relaxed);
+	}
+	void profile_write(uint16_t address);                                               // Escritura aplicada, para el LineProfiler
+
+	void trace(TraceEvent event, uint16_t address, MessageType type,
+	           uint8_t from_state = kNoState, uint8_t to_state = kNoState) const;
 };
 
+
+// Crea el controlador del protocolo elegido en tiempo de ejecución (barridos, benchmarks)
+MESIController* make_mesi_controller(ProtocolKind protocol, Cache* cache, Interconnect* interconnect, int pe_id,
+                                     size_t num_mshrs = DEFAULT_MSHRS);
+
 #endif // MESI_CONTROLLER_H
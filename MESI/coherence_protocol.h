@@ -0,0 +1,129 @@
+#ifndef COHERENCE_PROTOCOL_H
+#define COHERENCE_PROTOCOL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "../cache/include/Cache.h"
+
+using namespace std;
+
+// Estado de coherencia completo de una línea. La caché solo almacena MESIState, así que el
+// controlador guarda el estado real y proyecta OWNED como MODIFIED (sucio, se escribe al desalojar)
+// y FORWARD como SHARED.
+enum class LineState : uint8_t {
+    INVALID,
+    SHARED,
+    EXCLUSIVE,
+    MODIFIED,
+    OWNED,                                                                              // MOESI: sucio y compartido, responde en lugar de memoria
+    FORWARD,                                                                            // MESIF: único sharer que responde
+};
+
+constexpr size_t NUM_LINE_STATES = 6;
+
+constexpr MESIState to_cache_state(LineState state) {
+    constexpr MESIState projection[NUM_LINE_STATES] = {
+        MESIState::INVALID, MESIState::SHARED, MESIState::EXCLUSIVE,
+        MESIState::MODIFIED, MESIState::MODIFIED, MESIState::SHARED,
+    };
+    return projection[static_cast<size_t>(state)];
+}
+
+inline const char* line_state_name(LineState state) {
+    static const char* const names[NUM_LINE_STATES] = {"I", "S", "E", "M", "O", "F"};
+    return names[static_cast<size_t>(state)];
+}
+
+
+// Reacción de una caché que observa en el bus un miss de otro PE
+struct SnoopAction {
+    LineState next;                                                                     // Estado tras el snoop
+    bool supplies;                                                                      // Entrega la línea al solicitante
+    bool flush;                                                                         // Además la escribe en memoria
+};
+
+// Respuesta de un MESIController al interconnect
+struct SnoopReply {
+    bool had_line = false;                                                              // Señal "shared" del bus
+    bool supplied = false;                                                              // Escribió la línea en el destino
+    bool flush = false;                                                                 // La línea entregada debe ir a memoria
+};
+
+
+// ==================================================================================== POLÍTICAS ===
+
+enum class ProtocolKind {
+    MESI,
+    MOESI,
+    MESIF,
+};
+
+// Cada política es una tabla constexpr indexada por LineState: el controlador consulta la fila
+// sin ramas dependientes del protocolo. read_fill[shared] da el estado del solicitante tras un READ_MISS.
+
+struct MesiProtocol {
+    static constexpr const char* name = "MESI";
+    static constexpr LineState read_fill[2] = {LineState::EXCLUSIVE, LineState::SHARED};
+    static constexpr SnoopAction snoop_read[NUM_LINE_STATES] = {
+        {LineState::INVALID, false, false},                                             // I
+        {LineState::SHARED, true, false},                                               // S
+        {LineState::SHARED, true, false},                                               // E
+        {LineState::SHARED, true, true},                                                // M: entrega y escribe en memoria
+        {LineState::SHARED, true, true},                                                // O (no alcanzable)
+        {LineState::SHARED, true, false},                                               // F (no alcanzable)
+    };
+    static constexpr SnoopAction snoop_write[NUM_LINE_STATES] = {
+        {LineState::INVALID, false, false},
+        {LineState::INVALID, true, false},
+        {LineState::INVALID, true, false},
+        {LineState::INVALID, true, false},                                              // El solicitante queda MODIFIED, no hace falta flush
+        {LineState::INVALID, true, false},
+        {LineState::INVALID, true, false},
+    };
+};
+
+struct MoesiProtocol {
+    static constexpr const char* name = "MOESI";
+    static constexpr LineState read_fill[2] = {LineState::EXCLUSIVE, LineState::SHARED};
+    static constexpr SnoopAction snoop_read[NUM_LINE_STATES] = {
+        {LineState::INVALID, false, false},                                             // I
+        {LineState::SHARED, true, false},                                               // S
+        {LineState::SHARED, true, false},                                               // E
+        {LineState::OWNED, true, false},                                                // M -> O: comparte sin write-back
+        {LineState::OWNED, true, false},                                                // O sigue respondiendo
+        {LineState::SHARED, true, false},                                               // F (no alcanzable)
+    };
+    static constexpr SnoopAction snoop_write[NUM_LINE_STATES] = {
+        {LineState::INVALID, false, false},
+        {LineState::INVALID, true, false},
+        {LineState::INVALID, true, false},
+        {LineState::INVALID, true, false},
+        {LineState::INVALID, true, false},
+        {LineState::INVALID, true, false},
+    };
+};
+
+struct MesifProtocol {
+    static constexpr const char* name = "MESIF";
+    static constexpr LineState read_fill[2] = {LineState::EXCLUSIVE, LineState::FORWARD};  // El último lector pasa a ser el que responde
+    static constexpr SnoopAction snoop_read[NUM_LINE_STATES] = {
+        {LineState::INVALID, false, false},                                             // I
+        {LineState::SHARED, false, false},                                              // S no responde
+        {LineState::SHARED, true, false},                                               // E
+        {LineState::SHARED, true, true},                                                // M
+        {LineState::SHARED, true, true},                                                // O (no alcanzable)
+        {LineState::SHARED, true, false},                                               // F entrega y cede el rol
+    };
+    static constexpr SnoopAction snoop_write[NUM_LINE_STATES] = {
+        {LineState::INVALID, false, false},
+        {LineState::INVALID, false, false},                                             // S solo se invalida
+        {LineState::INVALID, true, false},
+        {LineState::INVALID, true, false},
+        {LineState::INVALID, true, false},
+        {LineState::INVALID, true, false},
+    };
+};
+
+#endif // COHERENCE_PROTOCOL_H
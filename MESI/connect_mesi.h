@@ -9,10 +9,12 @@
 #include "../PE/PE.h"
 
 
-inline void connect_mesi_controllers(std::vector<PE*>& pes, std::vector<Cache*>& caches, Interconnect* interconnect) {
+// El protocolo por defecto es MESI; MOESI y MESIF se eligen con ProtocolKind
+inline void connect_mesi_controllers(std::vector<PE*>& pes, std::vector<Cache*>& caches, Interconnect* interconnect,
+                                     ProtocolKind protocol = ProtocolKind::MESI) {
     // Inicializa el vector de MESIControllers en el Interconnect
     for (size_t i = 0; i < pes.size(); ++i) {
-        auto* mesi = new MESIController(caches[i], interconnect, pes[i]->get_id());
+        auto* mesi = make_mesi_controller(protocol, caches[i], interconnect, pes[i]->get_id());
         pes[i]->set_mesi_controller(mesi);
         interconnect->attach_mesi_controller(mesi, pes[i]->get_id());
     }
@@ -0,0 +1,138 @@
+#include <algorithm>
+
+#include "prefetcher.h"
+
+using namespace std;
+
+namespace {
+
+void push_block(int64_t block, vector<uint16_t>& out) {
+    if (block >= 0 && block < static_cast<int64_t>(NUM_BLOCKS)) out.push_back(static_cast<uint16_t>(block * WORDS_PER_LINE));
+}
+
+}
+
+
+const char* prefetch_kind_name(PrefetchKind kind) {
+    static const char* const names[NUM_PREFETCH_KINDS] = {"none", "next_line", "stride", "stream"};
+    return static_cast<size_t>(kind) < NUM_PREFETCH_KINDS ? names[static_cast<size_t>(kind)] : "unknown";
+}
+
+
+unique_ptr<Prefetcher> make_prefetcher(const PrefetchConfig& config) {
+    switch (config.kind) {
+        case PrefetchKind::NEXT_LINE: return make_unique<NextLinePrefetcher>(config);
+        case PrefetchKind::STRIDE: return make_unique<StridePrefetcher>(config);
+        case PrefetchKind::STREAM: return make_unique<StreamPrefetcher>(config);
+        case PrefetchKind::NONE:
+        default: return nullptr;
+    }
+}
+
+
+// ==================================================================================== NEXT-LINE ===
+
+
+void NextLinePrefetcher::observe(uint16_t address, bool trigger, vector<uint16_t>& out) {
+    if (!trigger) return;
+    int64_t block = static_cast<int64_t>(block_of(address));
+    for (size_t k = 1; k <= config_.degree; ++k) push_block(block + k, out);
+}
+
+
+// ==================================================================================== STRIDE ===
+
+
+StridePrefetcher::StridePrefetcher(const PrefetchConfig& config)
+    : Prefetcher(config), table_(max<size_t>(config.table_entries, 1)) {
+    region_shift_ = 0;
+    while ((size_t(2) << region_shift_) <= max<size_t>(config.region_words, 1)) region_shift_++;
+}
+
+
+// Entrena con todos los accesos; solo pide en los disparos. Con pasos menores que una línea se sigue
+// avanzando hasta juntar degree bloques distintos del actual.
+void StridePrefetcher::observe(uint16_t address, bool trigger, vector<uint16_t>& out) {
+    size_t region = address >> region_shift_;
+    Entry& entry = table_[region % table_.size()];
+    if (!entry.valid || entry.region != region) {
+        entry = Entry{true, region, address, 0, 0};
+        return;
+    }
+
+    int32_t delta = static_cast<int32_t>(address) - static_cast<int32_t>(entry.last);
+    if (delta == 0) return;
+    if (delta == entry.stride) {
+        entry.confidence = min<uint8_t>(entry.confidence + 1, 3);
+    } else if (entry.confidence > 0) {
+        entry.confidence--;
+    } else {
+        entry.stride = delta;
+    }
+    entry.last = address;
+
+    if (!trigger || entry.confidence < 2) return;
+    int64_t block = static_cast<int64_t>(block_of(address));
+    int64_t target = address;
+    size_t emitted = 0;
+    for (size_t step = 0; emitted < config_.degree && step < config_.degree * WORDS_PER_LINE; ++step) {
+        target += entry.stride;
+        if (target < 0 || target >= static_cast<int64_t>(ADDRESS_SPACE_WORDS)) break;
+        int64_t next = static_cast<int64_t>(target / WORDS_PER_LINE);
+        if (next == block) continue;
+        block = next;
+        push_block(next, out);
+        emitted++;
+    }
+}
+
+
+// ==================================================================================== STREAM ===
+
+
+StreamPrefetcher::StreamPrefetcher(const PrefetchConfig& config)
+    : Prefetcher(config), streams_(max<size_t>(config.streams, 1)) {}
+
+
+void StreamPrefetcher::observe(uint16_t address, bool trigger, vector<uint16_t>& out) {
+    if (!trigger) return;
+    int64_t block = static_cast<int64_t>(block_of(address));
+    tick_++;
+
+    Stream* stream = nullptr;
+    for (Stream& s : streams_) {
+        if (!s.valid) continue;
+        int64_t delta = block - s.last;
+        if (delta == 0 || (delta > -WINDOW - 1 && delta < WINDOW + 1 && (s.direction == 0 || (delta > 0) == (s.direction > 0)))) {
+            stream = &s;
+            break;
+        }
+    }
+
+    if (!stream) {                                                                      // Nuevo flujo en el de uso más antiguo
+        stream = &*min_element(streams_.begin(), streams_.end(), [](const Stream& a, const Stream& b) {
+            return a.valid != b.valid ? !a.valid : a.lru < b.lru;
+        });
+        *stream = Stream{true, block, block, 0, 0, tick_};
+        return;
+    }
+
+    stream->lru = tick_;
+    int64_t delta = block - stream->last;
+    if (delta == 0) return;
+    if (stream->direction == 0) {
+        stream->direction = delta > 0 ? 1 : -1;
+        stream->confirmations = 1;
+    } else if (stream->confirmations < 2) {
+        stream->confirmations++;
+    }
+    stream->last = block;
+    if (stream->confirmations < 2) return;
+
+    int dir = stream->direction;
+    if ((stream->next - block) * dir <= 0) stream->next = block + dir;                 // El flujo alcanzó a lo ya pedido
+    for (size_t emitted = 0; emitted < config_.degree && (stream->next - block) * dir <= static_cast<int64_t>(config_.distance); ++emitted) {
+        push_block(stream->next, out);
+        stream->next += dir;
+    }
+}
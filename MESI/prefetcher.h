@@ -0,0 +1,109 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../Interconnect/bus_types.h"
+
+using namespace std;
+
+enum class PrefetchKind : uint8_t {
+    NONE,
+    NEXT_LINE,                                                                          // Las líneas siguientes a cada miss
+    STRIDE,                                                                             // Paso constante por región de memoria
+    STREAM,                                                                             // Flujos secuenciales confirmados, en ambos sentidos
+};
+
+constexpr size_t NUM_PREFETCH_KINDS = 4;
+
+const char* prefetch_kind_name(PrefetchKind kind);
+
+
+struct PrefetchConfig {
+    PrefetchKind kind = PrefetchKind::NONE;
+    size_t degree = 2;                                                                  // Líneas pedidas por disparo
+    size_t distance = 4;                                                                // STREAM: líneas por delante del último miss
+    size_t table_entries = 16;                                                          // STRIDE: regiones seguidas
+    size_t region_words = 256;                                                          // STRIDE: tamaño de la región (potencia de dos)
+    size_t streams = 4;                                                                 // STREAM: flujos seguidos
+    double congestion_threshold = 0.5;                                                  // Ocupación de la cola del banco a partir de la cual no se pide
+};
+
+
+// Etapa de prefetch de un PE. El MESIController le pasa cada acceso de demanda (trigger: fue miss o
+// el primer uso de una línea traída por prefetch) y ella agrega a out las direcciones a traer.
+// Decide qué pedir; si se pide (línea ya presente, MSHRs, congestión del bus) lo decide el controlador.
+// Solo la usa el hilo del PE.
+class Prefetcher {
+public:
+    explicit Prefetcher(const PrefetchConfig& config) : config_(config) {}
+    virtual ~Prefetcher() = default;
+
+    virtual void observe(uint16_t address, bool trigger, vector<uint16_t>& out) = 0;
+
+    PrefetchKind kind() const { return config_.kind; }
+    const PrefetchConfig& config() const { return config_; }
+
+protected:
+    PrefetchConfig config_;
+};
+
+
+class NextLinePrefetcher final : public Prefetcher {
+public:
+    using Prefetcher::Prefetcher;
+    void observe(uint16_t address, bool trigger, vector<uint16_t>& out) override;
+};
+
+
+// Tabla de pasos por región (no hay PC en las trazas): cada entrada guarda la última dirección, el
+// paso y una confianza de 2 bits; con confianza >= 2 pide degree accesos adelante con ese paso.
+class StridePrefetcher final : public Prefetcher {
+public:
+    explicit StridePrefetcher(const PrefetchConfig& config);
+    void observe(uint16_t address, bool trigger, vector<uint16_t>& out) override;
+
+private:
+    struct Entry {
+        bool valid = false;
+        size_t region = 0;
+        uint16_t last = 0;
+        int32_t stride = 0;
+        uint8_t confidence = 0;
+    };
+    vector<Entry> table_;
+    size_t region_shift_ = 8;
+};
+
+
+// Detector de flujos: un miss a menos de WINDOW líneas del último miss de un flujo fija su sentido;
+// con dos misses en el mismo sentido el flujo queda confirmado y se pide hasta distance líneas por
+// delante, a lo sumo degree por disparo. Los flujos se reemplazan por LRU.
+class StreamPrefetcher final : public Prefetcher {
+public:
+    static constexpr int WINDOW = 4;
+
+    explicit StreamPrefetcher(const PrefetchConfig& config);
+    void observe(uint16_t address, bool trigger, vector<uint16_t>& out) override;
+
+private:
+    struct Stream {
+        bool valid = false;
+        int64_t last = 0;                                                               // Último bloque visto
+        int64_t next = 0;                                                               // Próximo bloque a pedir
+        int direction = 0;                                                              // 0: aún sin sentido
+        uint8_t confirmations = 0;
+        uint64_t lru = 0;
+    };
+    vector<Stream> streams_;
+    uint64_t tick_ = 0;
+};
+
+
+// nullptr con PrefetchKind::NONE
+unique_ptr<Prefetcher> make_prefetcher(const PrefetchConfig& config);
+
+#endif // PREFETCHER_H
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cmath>
+
+#include "memory_controller.h"
+
+using namespace std;
+
+MemoryController::MemoryController(Memoria* memoria, const DramConfig& config)
+    : memoria_(memoria), config_(config), banks_(max<size_t>(config.banks, 1)) {
+    config_.banks = banks_.size();
+    config_.lines_per_row = max<size_t>(config_.lines_per_row, 1);
+    double line_bytes = WORDS_PER_LINE * sizeof(double);
+    transfer_ns_ = config_.bandwidth_gb_s > 0.0 ? static_cast<uint32_t>(ceil(line_bytes / config_.bandwidth_gb_s)) : 0;
+    write_buffer_.reserve(config_.write_buffer_entries);
+}
+
+
+// Lectura de una línea: primero el buffer de write-back (dato más reciente), luego DRAM
+uint32_t MemoryController::read_line(size_t address, array<double,4>& linea, uint64_t now_ns) {
+    lock_guard<mutex> lock(mutex_);
+    stats_.reads.fetch_add(1, memory_order_relaxed);
+
+    size_t block = block_of(address);
+    uint32_t latency;
+    auto pending = find_if(write_buffer_.begin(), write_buffer_.end(), [&](const PendingWrite& w) { return w.block == block; });
+    if (pending != write_buffer_.end()) {
+        linea = pending->linea;
+        stats_.write_buffer_hits.fetch_add(1, memory_order_relaxed);
+        latency = config_.write_buffer_hit_ns;
+    } else {
+        linea = memoria_ ? memoria_->read_bloque(address) : array<double,4>{};
+        stats_.dram_reads.fetch_add(1, memory_order_relaxed);
+        latency = dram_access(address, now_ns);
+    }
+
+    stats_.read_latency_ns.fetch_add(latency, memory_order_relaxed);
+    stats_.read_ns.record(latency);
+    return latency;
+}
+
+
+// Dato actual de la línea (buffer de write-back o Memoria) para quien lo sirve desde otro nivel, como
+// la L2 de un cluster (ver Interconnect/topology.h)
+void MemoryController::peek_line(size_t address, array<double,4>& linea) {
+    lock_guard<mutex> lock(mutex_);
+    size_t block = block_of(address);
+    auto pending = find_if(write_buffer_.begin(), write_buffer_.end(), [&](const PendingWrite& w) { return w.block == block; });
+    if (pending != write_buffer_.end()) {
+        linea = pending->linea;
+    } else {
+        linea = memoria_ ? memoria_->read_bloque(address) : array<double,4>{};
+    }
+}
+
+
+// Escritura de una línea: queda en el buffer (fusionada si el bloque ya estaba); si el buffer está
+// lleno se drena la entrada más antigua. La latencia vista por el bus es la de aceptar la escritura.
+uint32_t MemoryController::write_line(size_t address, const array<double,4>& linea, uint64_t now_ns) {
+    lock_guard<mutex> lock(mutex_);
+    stats_.writes.fetch_add(1, memory_order_relaxed);
+
+    size_t block = block_of(address);
+    auto pending = find_if(write_buffer_.begin(), write_buffer_.end(), [&](const PendingWrite& w) { return w.block == block; });
+    if (pending != write_buffer_.end()) {
+        pending->linea = linea;
+        stats_.coalesced_writes.fetch_add(1, memory_order_relaxed);
+        return config_.write_buffer_hit_ns;
+    }
+
+    uint32_t latency = config_.write_buffer_hit_ns;
+    if (config_.write_buffer_entries == 0) {                                            // Sin buffer: escritura directa
+        if (memoria_) memoria_->write_bloque(address, linea);
+        stats_.dram_writes.fetch_add(1, memory_order_relaxed);
+        return dram_access(address, now_ns);
+    }
+    if (write_buffer_.size() >= config_.write_buffer_entries) {                         // Buffer lleno: espera a que drene uno
+        latency += drain_oldest(now_ns);
+    }
+    write_buffer_.push_back(PendingWrite{block, address, linea});
+    return latency;
+}
+
+
+void MemoryController::flush(uint64_t now_ns) {
+    lock_guard<mutex> lock(mutex_);
+    while (!write_buffer_.empty()) drain_oldest(now_ns);
+}
+
+
+// Escribe en DRAM la entrada más antigua del buffer (requiere mutex_)
+uint32_t MemoryController::drain_oldest(uint64_t now_ns) {
+    PendingWrite oldest = write_buffer_.front();
+    write_buffer_.erase(write_buffer_.begin());
+    if (memoria_) memoria_->write_bloque(oldest.address, oldest.linea);
+    stats_.dram_writes.fetch_add(1, memory_order_relaxed);
+    return dram_access(oldest.address, now_ns);
+}
+
+
+// Tiempo de un acceso a DRAM (requiere mutex_): estado de la fila del banco, espera por el banco y
+// por el canal, y transferencia limitada por el ancho de banda
+uint32_t MemoryController::dram_access(size_t address, uint64_t now_ns) {
+    size_t block = block_of(address);
+    size_t row_group = block / config_.lines_per_row;                                   // Líneas consecutivas comparten fila
+    DramBank& bank = banks_[row_group % banks_.size()];
+    int64_t row = static_cast<int64_t>(row_group / banks_.size());
+
+    uint32_t array_ns;
+    if (bank.open_row == row) {
+        array_ns = config_.row_hit_ns;
+        stats_.row_hits.fetch_add(1, memory_order_relaxed);
+    } else if (bank.open_row < 0) {
+        array_ns = config_.row_miss_ns;
+        stats_.row_misses.fetch_add(1, memory_order_relaxed);
+    } else {
+        array_ns = config_.row_conflict_ns;
+        stats_.row_conflicts.fetch_add(1, memory_order_relaxed);
+    }
+    bank.open_row = row;
+
+    uint64_t start = max(now_ns, bank.ready_ns);
+    uint64_t data_start = max(start + array_ns, channel_free_ns_);
+    channel_free_ns_ = data_start + transfer_ns_;
+    bank.ready_ns = data_start;
+    uint64_t done = channel_free_ns_;
+
+    stats_.queue_delay_ns.record((start - now_ns) + (data_start - start - array_ns));
+    return static_cast<uint32_t>(done - now_ns);
+}
@@ -0,0 +1,97 @@
+#ifndef MEMORY_CONTROLLER_H
+#define MEMORY_CONTROLLER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "../cache/include/memoria.h"
+#include "../Interconnect/bus_types.h"
+#include "../Stats/sim_stats.h"
+
+using namespace std;
+
+// Parámetros del modelo de DRAM y del buffer de write-back. Latencias en ns.
+struct DramConfig {
+    size_t banks = 8;
+    size_t lines_per_row = 32;                                                          // 32 líneas de 32 B: fila de 1 KB
+    uint32_t row_hit_ns = 15;                                                           // CAS con la fila ya abierta
+    uint32_t row_miss_ns = 30;                                                          // Banco sin fila abierta: ACT + CAS
+    uint32_t row_conflict_ns = 45;                                                      // Otra fila abierta: PRE + ACT + CAS
+    double bandwidth_gb_s = 12.8;                                                       // Tope del canal (bytes/ns)
+    size_t write_buffer_entries = 16;
+    uint32_t write_buffer_hit_ns = 2;                                                   // Lectura servida por el buffer
+};
+
+// Contadores del controlador de memoria (se incrementan con el mutex tomado; se leen sin él)
+struct MemoryStats {
+    atomic<uint64_t> reads{0};                                                          // Lecturas pedidas por el interconnect
+    atomic<uint64_t> writes{0};                                                         // Write-backs y flushes recibidos
+    atomic<uint64_t> dram_reads{0};
+    atomic<uint64_t> dram_writes{0};                                                    // Entradas drenadas del buffer
+    atomic<uint64_t> row_hits{0};
+    atomic<uint64_t> row_misses{0};
+    atomic<uint64_t> row_conflicts{0};
+    atomic<uint64_t> write_buffer_hits{0};                                              // Lecturas servidas por un write-back pendiente
+    atomic<uint64_t> coalesced_writes{0};                                               // Write-backs fusionados con uno pendiente
+    atomic<uint64_t> read_latency_ns{0};                                                // Suma de latencias de lectura
+    LatencyHistogram queue_delay_ns;                                                    // Espera por banco o por el canal
+    LatencyHistogram read_ns;
+
+    double row_hit_rate() const {
+        uint64_t n = row_hits + row_misses + row_conflicts;
+        return n ? static_cast<double>(row_hits) / n : 0.0;
+    }
+};
+
+
+// Controlador de memoria principal: hace funcional la ruta a Memoria y modela su tiempo.
+// Cada acceso a DRAM elige banco y fila (mapeo entrelazado por fila, política de página abierta),
+// espera a que el banco y el canal estén libres y devuelve la latencia modelada. Los write-backs
+// esperan en un buffer que fusiona escrituras repetidas al mismo bloque y atiende las lecturas
+// que lo encuentran; se drena a DRAM en orden de llegada cuando se llena o con flush().
+// El tiempo es el que indica quien llama (ns simulados o de reloj, ver Interconnect).
+class MemoryController {
+public:
+    MemoryController(Memoria* memoria, const DramConfig& config = DramConfig{});
+
+    // Devuelven la latencia modelada del acceso en ns
+    uint32_t read_line(size_t address, array<double,4>& linea, uint64_t now_ns);
+    uint32_t write_line(size_t address, const array<double,4>& linea, uint64_t now_ns);
+    void peek_line(size_t address, array<double,4>& linea);                             // Solo el dato: sin tiempo ni contadores
+    void flush(uint64_t now_ns);
+
+    const DramConfig& config() const { return config_; }
+    const MemoryStats& stats() const { return stats_; }
+
+private:
+    struct DramBank {
+        int64_t open_row = -1;
+        uint64_t ready_ns = 0;
+    };
+
+    struct PendingWrite {
+        size_t block;
+        size_t address;
+        array<double,4> linea;
+    };
+
+    Memoria* memoria_;
+    DramConfig config_;
+    uint32_t transfer_ns_;
+
+    mutex mutex_;
+    vector<DramBank> banks_;
+    uint64_t channel_free_ns_ = 0;
+    vector<PendingWrite> write_buffer_;                                                 // En orden de llegada
+
+    MemoryStats stats_;
+
+    uint32_t dram_access(size_t address, uint64_t now_ns);
+    uint32_t drain_oldest(uint64_t now_ns);
+};
+
+#endif // MEMORY_CONTROLLER_H
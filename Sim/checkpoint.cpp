@@ -0,0 +1,300 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+
+using namespace std;
+
+namespace {
+
+// Contadores de PeStats que viajan en el checkpoint, en este orden, seguidos de messages_sent
+constexpr atomic<uint64_t> PeStats::* kCounters[] = {
+    &PeStats::read_hits, &PeStats::read_misses, &PeStats::write_hits, &PeStats::write_misses,
+    &PeStats::invalidations_received, &PeStats::write_backs, &PeStats::cache_to_cache, &PeStats::memory_fills,
+    &PeStats::flushes, &PeStats::silent_upgrades, &PeStats::upgrade_fallbacks, &PeStats::mshr_merges,
+    &PeStats::mshr_full_stalls, &PeStats::prefetch_issued, &PeStats::prefetch_useful, &PeStats::prefetch_late,
+    &PeStats::prefetch_invalidated, &PeStats::prefetch_throttled, &PeStats::atomic_rmws, &PeStats::cas_failures,
+    &PeStats::store_conditionals, &PeStats::sc_failures,
+};
+constexpr size_t NUM_COUNTERS = sizeof(kCounters) / sizeof(kCounters[0]) + NUM_MESSAGE_TYPES;
+constexpr size_t NUM_BUS_COUNTERS = 4;                                                  // Más 2 por banco
+
+template <typename T>
+void append(vector<uint8_t>& out, const T& value) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+}
+
+
+// ==================================================================================== CHECKPOINT ===
+
+
+vector<uint8_t> encode_checkpoint(SimSystem& system) {
+    const int num_pes = system.config().num_pes;
+    Interconnect& interconnect = system.interconnect();
+    interconnect.flush_memory();                                                        // La imagen de memoria debe estar al día
+
+    vector<uint8_t> out;
+    out.reserve(sizeof(CheckpointHeader) + num_pes * sizeof(CheckpointPeEntry)
+                + NUM_BLOCKS * WORDS_PER_LINE * sizeof(double) + num_pes * NUM_COUNTERS * sizeof(uint64_t));
+
+    CheckpointHeader header{};
+    memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+    header.num_pes = num_pes;
+    header.protocol = static_cast<uint8_t>(system.config().protocol);
+    header.coherence_mode = static_cast<uint8_t>(system.config().coherence_mode);
+    header.num_blocks = static_cast<uint32_t>(NUM_BLOCKS);
+    header.words_per_line = static_cast<uint32_t>(WORDS_PER_LINE);
+    header.num_counters = static_cast<uint32_t>(NUM_COUNTERS);
+    header.num_banks = static_cast<uint32_t>(interconnect.get_num_banks());
+    append(out, header);
+
+    size_t table_offset = out.size();
+    out.resize(out.size() + num_pes * sizeof(CheckpointPeEntry));                       // Se completa al escribir las líneas
+
+    size_t memory_offset = out.size();
+    for (size_t block = 0; block < NUM_BLOCKS; ++block) {
+        append(out, system.memoria().read_bloque(block * WORDS_PER_LINE));
+    }
+
+    for (int pe = 0; pe < num_pes; ++pe) {
+        MESIController* mesi = system.controller(pe);
+        CheckpointPeEntry entry{pe, 0, out.size()};
+        for (size_t block = 0; block < NUM_BLOCKS; ++block) {
+            size_t address = block * WORDS_PER_LINE;
+            if (mesi->line_state(address) == LineState::INVALID) continue;
+            auto linea = mesi->line_data(address);
+            if (!linea.has_value()) continue;                                           // Desalojada en silencio
+            CheckpointLine line{};
+            line.block = static_cast<uint16_t>(block);
+            line.state = static_cast<uint8_t>(mesi->line_state(address));
+            memcpy(line.data, linea->data(), sizeof(line.data));
+            append(out, line);
+            entry.num_lines++;
+        }
+        memcpy(out.data() + table_offset + pe * sizeof(CheckpointPeEntry), &entry, sizeof(entry));
+    }
+
+    size_t counters_offset = out.size();
+    for (int pe = 0; pe < num_pes; ++pe) {
+        const PeStats& stats = interconnect.stats().pe(pe);
+        for (auto counter : kCounters) append(out, (stats.*counter).load(memory_order_relaxed));
+        for (const auto& sent : stats.messages_sent) append(out, sent.load(memory_order_relaxed));
+    }
+    Interconnect::BusCounters bus = interconnect.bus_counters();
+    append(out, bus.bus_traffic);
+    append(out, bus.snoop_messages);
+    append(out, bus.filtered_snoops);
+    append(out, bus.completed_transactions);
+    for (size_t i = 0; i < bus.bank_transactions.size(); ++i) {
+        append(out, bus.bank_transactions[i]);
+        append(out, bus.bank_busy_ns[i]);
+    }
+
+    CheckpointHeader* written = reinterpret_cast<CheckpointHeader*>(out.data());
+    written->memory_offset = memory_offset;
+    written->counters_offset = counters_offset;
+    return out;
+}
+
+
+bool save_checkpoint(SimSystem& system, const string& path) {
+    ofstream out(path, ios::binary);
+    if (!out) {
+        cerr << "[Checkpoint] No se pudo abrir " << path << endl;
+        return false;
+    }
+    vector<uint8_t> data = encode_checkpoint(system);
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<streamsize>(data.size()));
+    return static_cast<bool>(out);
+}
+
+
+bool restore_checkpoint(SimSystem& system, const uint8_t* data, size_t size) {
+    const int num_pes = system.config().num_pes;
+    CheckpointHeader header;
+    if (!data || size < sizeof(header)) {
+        cerr << "[Checkpoint] Checkpoint vacío" << endl;
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, kCheckpointMagic, sizeof(header.magic)) != 0 || header.num_blocks != NUM_BLOCKS
+        || header.words_per_line != WORDS_PER_LINE || header.num_counters != NUM_COUNTERS) {
+        cerr << "[Checkpoint] Formato de checkpoint no reconocido" << endl;
+        return false;
+    }
+    if (header.num_pes != num_pes || header.protocol != static_cast<uint8_t>(system.config().protocol)
+        || header.coherence_mode != static_cast<uint8_t>(system.config().coherence_mode)
+        || header.num_banks != system.interconnect().get_num_banks()) {
+        cerr << "[Checkpoint] El checkpoint es de otra configuración (" << header.num_pes << " PEs, "
+             << protocol_kind_name(static_cast<ProtocolKind>(header.protocol)) << ", " << header.num_banks << " bancos)" << endl;
+        return false;
+    }
+
+    size_t table_end = sizeof(header) + num_pes * sizeof(CheckpointPeEntry);
+    size_t memory_bytes = NUM_BLOCKS * WORDS_PER_LINE * sizeof(double);
+    size_t counter_bytes = (num_pes * NUM_COUNTERS + NUM_BUS_COUNTERS + 2 * header.num_banks) * sizeof(uint64_t);
+    if (table_end > size || header.memory_offset + memory_bytes > size || header.counters_offset + counter_bytes > size) {
+        cerr << "[Checkpoint] Checkpoint truncado" << endl;
+        return false;
+    }
+    for (int pe = 0; pe < num_pes; ++pe) {
+        CheckpointPeEntry entry;
+        memcpy(&entry, data + sizeof(header) + pe * sizeof(entry), sizeof(entry));
+        if (entry.pe_id != pe || entry.offset + uint64_t(entry.num_lines) * sizeof(CheckpointLine) > size) {
+            cerr << "[Checkpoint] Líneas del PE " << pe << " fuera del checkpoint" << endl;
+            return false;
+        }
+        for (uint32_t i = 0; i < entry.num_lines; ++i) {                                // Antes de tocar el sistema
+            CheckpointLine line;
+            memcpy(&line, data + entry.offset + i * sizeof(line), sizeof(line));
+            if (line.block >= NUM_BLOCKS || line.state >= NUM_LINE_STATES) {
+                cerr << "[Checkpoint] Línea inválida del PE " << pe << " (bloque " << line.block
+                     << ", estado " << static_cast<int>(line.state) << ")" << endl;
+                return false;
+            }
+        }
+    }
+
+    Interconnect& interconnect = system.interconnect();
+    interconnect.flush_memory();
+    for (int pe = 0; pe < num_pes; ++pe) system.controller(pe)->invalidate_all();
+    interconnect.clear_topology();
+
+    array<double,4> linea;
+    for (size_t block = 0; block < NUM_BLOCKS; ++block) {
+        memcpy(linea.data(), data + header.memory_offset + block * sizeof(linea), sizeof(linea));
+        system.memoria().write_bloque(block * WORDS_PER_LINE, linea);
+    }
+
+    Directory& directory = interconnect.directory();
+    bool use_directory = system.config().coherence_mode == CoherenceMode::DIRECTORY;
+    if (use_directory) directory.clear();
+
+    for (int pe = 0; pe < num_pes; ++pe) {
+        CheckpointPeEntry entry;
+        memcpy(&entry, data + sizeof(header) + pe * sizeof(entry), sizeof(entry));
+        MESIController* mesi = system.controller(pe);
+        for (uint32_t i = 0; i < entry.num_lines; ++i) {
+            CheckpointLine line;
+            memcpy(&line, data + entry.offset + i * sizeof(line), sizeof(line));
+            size_t address = static_cast<size_t>(line.block) * WORDS_PER_LINE;
+            LineState state = static_cast<LineState>(line.state);
+            memcpy(linea.data(), line.data, sizeof(linea));
+            mesi->restore_line(address, state, linea);
+
+            if (use_directory) {
+                if (state == LineState::EXCLUSIVE || state == LineState::MODIFIED) {
+                    directory.set_owner(address, pe);
+                } else {
+                    directory.add_sharer(address, pe);
+                }
+            }
+            interconnect.fill_cluster_l2(pe, address);                                  // La L2 inclusiva se rearma con las L1
+        }
+    }
+
+    interconnect.reset_stats();
+    const uint8_t* counters = data + header.counters_offset;
+    for (int pe = 0; pe < num_pes; ++pe) {
+        PeStats& stats = interconnect.stats().pe(pe);
+        uint64_t value;
+        for (auto counter : kCounters) {
+            memcpy(&value, counters, sizeof(value));
+            counters += sizeof(value);
+            (stats.*counter).store(value, memory_order_relaxed);
+        }
+        for (auto& sent : stats.messages_sent) {
+            memcpy(&value, counters, sizeof(value));
+            counters += sizeof(value);
+            sent.store(value, memory_order_relaxed);
+        }
+    }
+
+    auto next = [&counters] {
+        uint64_t value;
+        memcpy(&value, counters, sizeof(value));
+        counters += sizeof(value);
+        return value;
+    };
+    Interconnect::BusCounters bus;
+    bus.bus_traffic = next();
+    bus.snoop_messages = next();
+    bus.filtered_snoops = next();
+    bus.completed_transactions = next();
+    for (uint32_t i = 0; i < header.num_banks; ++i) {
+        bus.bank_transactions.push_back(next());
+        bus.bank_busy_ns.push_back(next());
+    }
+    return interconnect.restore_bus_counters(bus);
+}
+
+
+bool restore_checkpoint(SimSystem& system, const string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "[Checkpoint] No se pudo abrir " << path << endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(CheckpointHeader))) {
+        cerr << "[Checkpoint] Checkpoint vacío o ilegible: " << path << endl;
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);                                                                        // El mapeo sigue válido sin el descriptor
+    if (addr == MAP_FAILED) {
+        cerr << "[Checkpoint] mmap falló para " << path << endl;
+        return false;
+    }
+    madvise(addr, size, MADV_SEQUENTIAL);
+
+    bool ok = restore_checkpoint(system, static_cast<const uint8_t*>(addr), size);
+    munmap(addr, size);
+    return ok;
+}
+
+
+// ==================================================================================== FAST-FORWARD ===
+
+
+uint64_t fast_forward(SimSystem& system, WorkloadTrace& trace, size_t records_per_stream) {
+    Interconnect& interconnect = system.interconnect();
+    const auto& streams = trace.streams();
+
+    interconnect.begin_fast_forward();
+    uint64_t operations = 0;
+    for (size_t i = 0; i < records_per_stream; ++i) {                                   // De a un registro por flujo
+        bool any = false;
+        for (const WorkloadStream& stream : streams) {
+            if (i >= stream.count || stream.pe_id < 0 || stream.pe_id >= system.config().num_pes) continue;
+            const WorkloadRecord& record = stream.records[i];
+            MESIController* mesi = system.controller(stream.pe_id);
+            if (record.op == WorkloadOp::WRITE) {
+                mesi->write(record.address, record.value);
+            } else {
+                mesi->read(record.address);
+            }
+            operations++;
+            any = true;
+        }
+        if (!any) break;
+    }
+    interconnect.end_fast_forward();
+
+    trace.drop_front(records_per_stream);
+    return operations;
+}
@@ -0,0 +1,82 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sim_system.h"
+#include "../Workload/workload_trace.h"
+
+using namespace std;
+
+// ==================================================================================== FORMATO BINARIO ===
+
+// Checkpoint del estado de coherencia completo de un SimSystem detenido (sin transacciones en vuelo,
+// así las colas del interconnect están vacías y no se guardan):
+//
+//   CheckpointHeader | CheckpointPeEntry[num_pes] | imagen de memoria | CheckpointLine[...] | contadores
+//   | contadores del bus
+//
+// La memoria se guarda tras vaciar el buffer de write-back; cada PE guarda sus líneas válidas con el
+// estado real (incluye O y F) y sus contadores de SimStats. Los contadores del bus son los de
+// Interconnect::BusCounters: bus_traffic, snoop_messages, consultas filtradas y transacciones
+// completadas (4 uint64_t), y luego transacciones y tiempo ocupado de cada banco (2 * num_banks).
+// Los histogramas y el estado de los bancos de DRAM no se guardan: una corrida restaurada arranca sus
+// tiempos de cero.
+
+constexpr char kCheckpointMagic[8] = {'M', 'P', 'C', 'K', 'P', 'T', '0', '2'};
+
+struct CheckpointHeader {
+    char magic[8];
+    int32_t num_pes;
+    uint8_t protocol;                                                                   // ProtocolKind
+    uint8_t coherence_mode;                                                             // CoherenceMode
+    uint16_t reserved;
+    uint32_t num_blocks;
+    uint32_t words_per_line;
+    uint32_t num_counters;                                                              // Contadores por PE
+    uint32_t num_banks;                                                                 // Bancos del bus
+    uint64_t memory_offset;                                                             // Bytes desde el inicio
+    uint64_t counters_offset;                                                           // Los del bus siguen a los de los PEs
+};
+
+struct CheckpointPeEntry {
+    int32_t pe_id;
+    uint32_t num_lines;
+    uint64_t offset;                                                                    // Primer CheckpointLine del PE
+};
+
+struct CheckpointLine {
+    uint16_t block;
+    uint8_t state;                                                                      // LineState
+    uint8_t reserved[5];
+    double data[4];
+};
+
+static_assert(sizeof(CheckpointHeader) == 48 && sizeof(CheckpointPeEntry) == 16 && sizeof(CheckpointLine) == 40,
+              "Formato binario del checkpoint");
+
+
+// ==================================================================================== CHECKPOINT ===
+
+// Arma el checkpoint en un buffer contiguo; save_checkpoint lo escribe con una sola escritura
+vector<uint8_t> encode_checkpoint(SimSystem& system);
+bool save_checkpoint(SimSystem& system, const string& path);
+
+// Restaura sobre un sistema con la misma cantidad de PEs, protocolo, modo de coherencia y bancos del
+// bus. Lee los registros en sitio (el archivo se abre con mmap) y no reserva memoria por línea.
+bool restore_checkpoint(SimSystem& system, const uint8_t* data, size_t size);
+bool restore_checkpoint(SimSystem& system, const string& path);
+
+
+// ==================================================================================== FAST-FORWARD ===
+
+// Reproduce funcionalmente los primeros records_per_stream registros de cada flujo, intercalando los
+// flujos de a un registro y sin pausas: cachés y estados quedan como tras la carga, pero sin bus,
+// trazas ni modelo de tiempo. Al terminar el sistema vuelve al modo detallado con los contadores en
+// cero y la carga sin esos registros (drop_front). Un solo hilo; los PEs no deben estar corriendo.
+uint64_t fast_forward(SimSystem& system, WorkloadTrace& trace, size_t records_per_stream);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "event_engine.h"
+
+using namespace std;
+
+EventEngine::EventEngine(SimSystem& system, const LatencyModel& latency)
+    : system_(system), latency_(latency) {}
+
+
+EventSimResult EventEngine::run(const WorkloadTrace& trace) {
+    EventSimResult result;
+    Interconnect& interconnect = system_.interconnect();
+    if (interconnect.get_bus_mode() != BusMode::INLINE) {
+        cerr << "[EventEngine] El sistema debe usar BusMode::INLINE" << endl;
+        return result;
+    }
+
+    const auto& streams = trace.streams();
+    vector<size_t> cursor(streams.size(), 0);
+    EventQueue queue;
+    for (size_t s = 0; s < streams.size(); ++s) {
+        int pe = streams[s].pe_id;
+        if (pe < 0 || pe >= system_.config().num_pes) {
+            cerr << "[EventEngine] Flujo del PE " << pe << " sin controlador, se ignora" << endl;
+            continue;
+        }
+        if (streams[s].count) queue.push(streams[s].records[0].think_ns, static_cast<uint32_t>(s));
+    }
+
+    // Con más de un MSHR el PE sigue emitiendo mientras sus misses están en vuelo: cada flujo guarda
+    // (bloque, fin) de sus misses; un acceso posterior al mismo bloque termina junto con su miss.
+    struct InFlightMiss {
+        size_t block;
+        uint64_t done;
+    };
+    size_t mshrs = system_.config().mshrs_per_pe;
+    bool non_blocking = mshrs > 1;
+    vector<vector<InFlightMiss>> in_flight(streams.size());
+    vector<vector<InFlightMiss>> prefetching(streams.size());                           // Prefetches en vuelo de cada flujo
+
+    const MemoryStats& memory = interconnect.memory().stats();
+    const Topology* topology = interconnect.topology();
+    auto network = [&] { return topology ? topology->stats().network_cycles.load(memory_order_relaxed) : 0; };
+    vector<uint64_t> bank_free_at(interconnect.get_num_banks(), 0);                      // Cada banco es un recurso independiente
+    auto start = chrono::steady_clock::now();
+
+    while (!queue.empty()) {
+        SimEvent event = queue.pop();
+        const WorkloadStream& stream = streams[event.stream];
+        const WorkloadRecord& record = stream.records[cursor[event.stream]];
+        MESIController* mesi = system_.controller(stream.pe_id);
+        PeStats& stats = interconnect.stats().pe(stream.pe_id);
+
+        vector<InFlightMiss>& misses = in_flight[event.stream];
+        if (non_blocking) {
+            misses.erase(remove_if(misses.begin(), misses.end(), [&](const InFlightMiss& m) { return m.done <= event.time; }),
+                         misses.end());
+            if (misses.size() >= mshrs) {                                               // Sin MSHR libre: el PE deja de emitir
+                uint64_t first_free = min_element(misses.begin(), misses.end(),
+                                                  [](const InFlightMiss& a, const InFlightMiss& b) { return a.done < b.done; })->done;
+                queue.push(first_free, event.stream);
+                result.mshr_stall_cycles += first_free - event.time;
+                continue;
+            }
+        }
+
+        // Lo que el acceso hizo en el bus se lee como diferencia de contadores (un solo hilo)
+        uint64_t tx_before = interconnect.get_completed_transactions();
+        uint64_t c2c_before = stats.cache_to_cache.load(memory_order_relaxed);
+        uint64_t mem_before = memory.read_latency_ns.load(memory_order_relaxed);
+        uint64_t wb_before = stats.write_backs.load(memory_order_relaxed);
+        uint64_t net_before = network();
+
+        uint64_t& bus_free_at = bank_free_at[block_of(record.address) % bank_free_at.size()];
+        uint64_t grant = max(event.time, bus_free_at);                                  // Si hay transacción, espera a que su banco se libere
+        interconnect.set_sim_time(grant);                                               // La DRAM ve el pedido cuando el bus lo concede
+        if (record.op == WorkloadOp::WRITE) {
+            mesi->write(record.address, record.value);
+        } else {
+            mesi->read(record.address);
+        }
+
+        uint64_t latency = latency_.hit_cycles;
+        uint64_t transactions = interconnect.get_completed_transactions() - tx_before;
+        if (transactions) {
+            uint64_t occupancy = transactions * latency_.bus_cycles;
+            occupancy += (stats.cache_to_cache.load(memory_order_relaxed) - c2c_before) * latency_.cache_to_cache_cycles;
+            occupancy += memory.read_latency_ns.load(memory_order_relaxed) - mem_before;  // Latencia del modelo de DRAM
+            occupancy += (stats.write_backs.load(memory_order_relaxed) - wb_before) * latency_.write_back_cycles;
+            occupancy += network() - net_before;                                        // L2 y red entre nodos
+            result.network_cycles += network() - net_before;
+
+            bus_free_at = grant + occupancy;
+            result.bus_busy_cycles += occupancy;
+            latency = bus_free_at - event.time;
+            if (non_blocking) misses.push_back(InFlightMiss{block_of(record.address), event.time + latency});
+        } else {
+            size_t block = block_of(record.address);
+            for (const InFlightMiss& m : misses) {                                      // Fusionado en el MSHR de su bloque
+                if (m.block == block) latency = max<uint64_t>(latency, m.done - event.time);
+            }
+            for (const InFlightMiss& m : prefetching[event.stream]) {                   // La línea llegó por un prefetch que no terminó
+                if (m.block == block && m.done > event.time) latency = max<uint64_t>(latency, m.done - event.time);
+            }
+        }
+
+        uint64_t done = event.time + latency;
+        access_latency_.record(latency);
+        result.operations++;
+        result.cycles = max(result.cycles, done);
+
+        uint64_t issue_next = non_blocking ? event.time + latency_.hit_cycles : done;   // Bloqueante: espera su propio acceso
+
+        vector<InFlightMiss>& prefetches = prefetching[event.stream];
+        prefetches.erase(remove_if(prefetches.begin(), prefetches.end(), [&](const InFlightMiss& m) { return m.done <= event.time; }),
+                         prefetches.end());
+        while (optional<uint16_t> address = mesi->next_prefetch()) {                    // Prefetches emitidos por este acceso
+            uint64_t& prefetch_bank = bank_free_at[block_of(*address) % bank_free_at.size()];
+            uint64_t prefetch_grant = max(issue_next, prefetch_bank);
+
+            tx_before = interconnect.get_completed_transactions();
+            c2c_before = stats.cache_to_cache.load(memory_order_relaxed);
+            mem_before = memory.read_latency_ns.load(memory_order_relaxed);
+            wb_before = stats.write_backs.load(memory_order_relaxed);
+            net_before = network();
+            interconnect.set_sim_time(prefetch_grant);
+            mesi->retire_prefetch();
+
+            uint64_t occupancy = (interconnect.get_completed_transactions() - tx_before) * latency_.bus_cycles;
+            occupancy += (stats.cache_to_cache.load(memory_order_relaxed) - c2c_before) * latency_.cache_to_cache_cycles;
+            occupancy += memory.read_latency_ns.load(memory_order_relaxed) - mem_before;
+            occupancy += (stats.write_backs.load(memory_order_relaxed) - wb_before) * latency_.write_back_cycles;
+            occupancy += network() - net_before;
+            result.network_cycles += network() - net_before;
+
+            prefetch_bank = prefetch_grant + occupancy;
+            result.bus_busy_cycles += occupancy;
+            result.prefetch_bus_cycles += occupancy;
+            prefetches.push_back(InFlightMiss{block_of(*address), prefetch_grant + occupancy});
+        }
+        size_t next = ++cursor[event.stream];
+        if (next < stream.count) queue.push(issue_next + stream.records[next].think_ns, event.stream);
+    }
+
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
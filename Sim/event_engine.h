@@ -0,0 +1,97 @@
+#ifndef EVENT_ENGINE_H
+#define EVENT_ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "sim_system.h"
+#include "../Stats/sim_stats.h"
+#include "../Workload/workload_trace.h"
+
+using namespace std;
+
+// ==================================================================================== COLA DE EVENTOS ===
+
+// Evento con marca de tiempo simulada (ciclos): el siguiente acceso de un flujo de la carga.
+// seq desempata en orden de inserción, así dos corridas con la misma carga dan el mismo orden.
+struct SimEvent {
+    uint64_t time;
+    uint64_t seq;
+    uint32_t stream;
+
+    bool operator>(const SimEvent& other) const {
+        return time != other.time ? time > other.time : seq > other.seq;
+    }
+};
+
+class EventQueue {
+public:
+    void push(uint64_t time, uint32_t stream) { heap_.push(SimEvent{time, next_seq_++, stream}); }
+    SimEvent pop() {
+        SimEvent event = heap_.top();
+        heap_.pop();
+        return event;
+    }
+    bool empty() const { return heap_.empty(); }
+    size_t size() const { return heap_.size(); }
+
+private:
+    priority_queue<SimEvent, vector<SimEvent>, greater<SimEvent>> heap_;
+    uint64_t next_seq_ = 0;
+};
+
+
+// ==================================================================================== MOTOR ===
+
+// Latencias modeladas, en ciclos. think_ns de la carga se toma como ciclos (1 ciclo = 1 ns).
+// Las lecturas de memoria principal no tienen costo fijo: toman la latencia que devuelve el modelo
+// de DRAM (Memory/memory_controller.h), que corre con el mismo reloj simulado.
+struct LatencyModel {
+    uint32_t hit_cycles = 1;
+    uint32_t bus_cycles = 4;                                                            // Arbitraje + dirección, toda transacción
+    uint32_t cache_to_cache_cycles = 20;                                                // Datos entregados por otra caché
+    uint32_t write_back_cycles = 20;                                                    // Víctima sucia escrita en la transacción
+};
+
+struct EventSimResult {
+    uint64_t operations = 0;
+    uint64_t cycles = 0;                                                                // Tiempo simulado hasta el último acceso
+    uint64_t bus_busy_cycles = 0;                                                       // Suma sobre todos los bancos
+    uint64_t mshr_stall_cycles = 0;                                                     // PEs detenidos por falta de MSHR
+    uint64_t prefetch_bus_cycles = 0;                                                   // Parte de bus_busy_cycles usada por prefetches
+    uint64_t network_cycles = 0;                                                        // Parte de bus_busy_cycles en L2 y red entre nodos
+    double seconds = 0.0;                                                               // Tiempo real de la corrida
+
+    double operations_per_second() const { return seconds > 0.0 ? operations / seconds : 0.0; }
+};
+
+
+// Motor de eventos discretos de un solo hilo. Cada acceso de un PE es un evento: se ejecuta con la
+// lógica real de MESIController e Interconnect (bus INLINE) y su latencia se modela a partir de lo
+// que registraron los contadores de SimStats durante el acceso. Cada banco del bus es un recurso:
+// una transacción empieza cuando el banco de su bloque se libera. El estado de coherencia se actualiza al procesar el
+// evento (modelo funcional primero), no al terminar la latencia.
+// Con SimConfig::mshrs_per_pe > 1 el PE no espera sus misses: emite el siguiente acceso tras un
+// ciclo y solo se detiene cuando tiene mshrs_per_pe misses en vuelo.
+// Los prefetches del acceso se ejecutan después de medirlo, uno por uno: ocupan el banco de su bloque
+// desde que el PE los emite, y un acceso posterior a esa línea espera a que el prefetch termine.
+// Con topología jerárquica (Interconnect/topology.h) la transacción suma además la consulta a la L2 y
+// la ida y vuelta por la red hasta el nodo más lejano que involucró.
+class EventEngine {
+public:
+    EventEngine(SimSystem& system, const LatencyModel& latency = LatencyModel{});
+
+    EventSimResult run(const WorkloadTrace& trace);
+
+    const LatencyHistogram& access_latency() const { return access_latency_; }           // Ciclos por acceso
+
+private:
+    SimSystem& system_;
+    LatencyModel latency_;
+    LatencyHistogram access_latency_;
+};
+
+#endif // EVENT_ENGINE_H
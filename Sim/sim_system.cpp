@@ -0,0 +1,77 @@
+#include "sim_system.h"
+
+using namespace std;
+
+const char* protocol_kind_name(ProtocolKind protocol) {
+    switch (protocol) {
+        case ProtocolKind::MOESI: return MoesiProtocol::name;
+        case ProtocolKind::MESIF: return MesifProtocol::name;
+        case ProtocolKind::MESI:
+        default: return MesiProtocol::name;
+    }
+}
+
+
+const char* coherence_mode_name(CoherenceMode mode) {
+    return mode == CoherenceMode::DIRECTORY ? "directory" : "snoop";
+}
+
+
+const char* bus_mode_name(BusMode mode) {
+    switch (mode) {
+        case BusMode::SPLIT: return "split";
+        case BusMode::INLINE: return "inline";
+        case BusMode::ATOMIC:
+        default: return "atomic";
+    }
+}
+
+
+SimSystem::SimSystem(const SimConfig& config)
+    : config_(config), memoria_(make_unique<Memoria>()) {
+
+    interconnect_ = make_unique<Interconnect>(config_.num_pes, memoria_.get(), config_.queue_depth,
+                                              config_.num_banks, config_.coherence_mode, config_.bus_mode,
+                                              config_.dram, config_.topology);
+
+    for (int pe = 0; pe < config_.num_pes; ++pe) {
+        caches_.push_back(config_.cache_lines ? make_unique<Cache>(config_.cache_lines) : make_unique<Cache>());
+        controllers_.emplace_back(make_mesi_controller(config_.protocol, caches_.back().get(), interconnect_.get(), pe,
+                                                                  config_.mshrs_per_pe));
+        controllers_.back()->set_prefetcher(make_prefetcher(config_.prefetch));
+        interconnect_->attach_mesi_controller(controllers_.back().get(), pe);
+    }
+}
+
+
+// El interconnect se detiene primero: su árbitro no debe ver controladores ya destruidos
+SimSystem::~SimSystem() {
+    interconnect_.reset();
+}
+
+
+vector<MESIController*> SimSystem::controllers() const {
+    vector<MESIController*> out;
+    out.reserve(controllers_.size());
+    for (const auto& c : controllers_) out.push_back(c.get());
+    return out;
+}
+
+
+SimTotals SimSystem::totals() const {
+    SimTotals totals;
+    const SimStats& stats = interconnect_->stats();
+    for (int pe = 0; pe < stats.num_pes(); ++pe) {
+        const PeStats& s = stats.pe(pe);
+        totals.read_hits += s.read_hits.load(memory_order_relaxed);
+        totals.read_misses += s.read_misses.load(memory_order_relaxed);
+        totals.write_hits += s.write_hits.load(memory_order_relaxed);
+        totals.write_misses += s.write_misses.load(memory_order_relaxed);
+        for (const auto& sent : s.messages_sent) totals.messages += sent.load(memory_order_relaxed);
+        totals.prefetch_issued += s.prefetch_issued.load(memory_order_relaxed);
+        totals.prefetch_useful += s.prefetch_useful.load(memory_order_relaxed);
+        totals.prefetch_late += s.prefetch_late.load(memory_order_relaxed);
+        totals.prefetch_invalidated += s.prefetch_invalidated.load(memory_order_relaxed);
+    }
+    return totals;
+}
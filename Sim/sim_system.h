@@ -0,0 +1,97 @@
+#ifndef SIM_SYSTEM_H
+#define SIM_SYSTEM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../cache/include/Cache.h"
+#include "../cache/include/memoria.h"
+#include "../Interconnect/interconnect.h"
+#include "../MESI/MESIController.h"
+#include "../MESI/coherence_protocol.h"
+#include "../MESI/prefetcher.h"
+
+using namespace std;
+
+// Configuración completa de un sistema simulado
+struct SimConfig {
+    int num_pes = 4;
+    ProtocolKind protocol = ProtocolKind::MESI;
+    CoherenceMode coherence_mode = CoherenceMode::SNOOP;
+    BusMode bus_mode = BusMode::ATOMIC;
+    size_t queue_depth = 16;
+    size_t num_banks = 1;
+    size_t mshrs_per_pe = 1;                                                            // 1: caché bloqueante
+    size_t cache_lines = 0;                                                             // Líneas por caché; 0: tamaño por defecto de Cache
+    PrefetchConfig prefetch;                                                            // El mismo prefetcher en todos los PEs
+    DramConfig dram;
+    TopologyConfig topology;                                                            // pes_per_cluster = 0: bus plano
+};
+
+const char* protocol_kind_name(ProtocolKind protocol);
+const char* coherence_mode_name(CoherenceMode mode);
+const char* bus_mode_name(BusMode mode);
+
+
+// Totales de todos los PEs (contadores de SimStats sumados)
+struct SimTotals {
+    uint64_t read_hits = 0;
+    uint64_t read_misses = 0;
+    uint64_t write_hits = 0;
+    uint64_t write_misses = 0;
+    uint64_t messages = 0;                                                              // Mensajes enviados al bus, todos los tipos
+    uint64_t prefetch_issued = 0;
+    uint64_t prefetch_useful = 0;
+    uint64_t prefetch_late = 0;
+    uint64_t prefetch_invalidated = 0;
+
+    uint64_t accesses() const { return read_hits + read_misses + write_hits + write_misses; }
+    double miss_ratio() const {
+        uint64_t n = accesses();
+        return n ? static_cast<double>(read_misses + write_misses) / n : 0.0;
+    }
+    // Prefetches usados (a tiempo o tarde) sobre los pedidos
+    double prefetch_accuracy() const {
+        return prefetch_issued ? static_cast<double>(prefetch_useful + prefetch_late) / prefetch_issued : 0.0;
+    }
+    // Misses evitados sobre los que habría sin prefetch (los tardíos siguen contando como miss)
+    double prefetch_coverage() const {
+        uint64_t n = prefetch_useful + read_misses + write_misses;
+        return n ? static_cast<double>(prefetch_useful) / n : 0.0;
+    }
+    // Fracción de los mensajes del bus que son prefetches
+    double prefetch_traffic_share() const {
+        return messages ? static_cast<double>(prefetch_issued) / messages : 0.0;
+    }
+};
+
+
+// Memoria, cachés, interconnect y controladores de coherencia de una corrida, creados y destruidos
+// juntos. Sin PEs: quien usa el sistema (replayer, benchmarks) llama directamente a los controladores.
+class SimSystem {
+public:
+    explicit SimSystem(const SimConfig& config);
+    ~SimSystem();
+
+    SimSystem(const SimSystem&) = delete;
+    SimSystem& operator=(const SimSystem&) = delete;
+
+    const SimConfig& config() const { return config_; }
+    Interconnect& interconnect() { return *interconnect_; }
+    Memoria& memoria() { return *memoria_; }
+    MESIController* controller(int pe_id) { return controllers_[pe_id].get(); }
+    vector<MESIController*> controllers() const;
+
+    SimTotals totals() const;
+
+private:
+    SimConfig config_;
+    unique_ptr<Memoria> memoria_;
+    vector<unique_ptr<Cache>> caches_;
+    unique_ptr<Interconnect> interconnect_;
+    vector<unique_ptr<MESIController>> controllers_;
+};
+
+#endif // SIM_SYSTEM_H
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "sweep.h"
+
+using namespace std;
+
+namespace {
+
+// Cola de índices de un trabajador: el dueño toma del frente, los ladrones del final
+struct alignas(64) WorkerQueue {
+    mutex m;
+    deque<size_t> jobs;
+
+    bool pop_front(size_t& job) {
+        lock_guard<mutex> lock(m);
+        if (jobs.empty()) return false;
+        job = jobs.front();
+        jobs.pop_front();
+        return true;
+    }
+
+    bool steal_back(size_t& job) {
+        lock_guard<mutex> lock(m);
+        if (jobs.empty()) return false;
+        job = jobs.back();
+        jobs.pop_back();
+        return true;
+    }
+};
+
+}
+
+
+SweepRunner::SweepRunner(size_t workers)
+    : workers_(workers ? workers : max<size_t>(thread::hardware_concurrency(), 1)) {}
+
+
+size_t SweepRunner::add(const string& workload, const WorkloadTrace& trace, const SimConfig& config,
+                        const LatencyModel& latency) {
+    SweepJob job{workload, &trace, config, latency};
+    job.config.bus_mode = BusMode::INLINE;                                              // Un hilo por simulación
+    jobs_.push_back(job);
+    return jobs_.size() - 1;
+}
+
+
+vector<SweepResult> SweepRunner::run() {
+    vector<SweepResult> results(jobs_.size());
+    size_t num_workers = min(workers_, max<size_t>(jobs_.size(), 1));
+    vector<WorkerQueue> queues(num_workers);
+    for (size_t i = 0; i < jobs_.size(); ++i) queues[i % num_workers].jobs.push_back(i);    // Reparto inicial intercalado
+
+    atomic<size_t> remaining{jobs_.size()};
+    vector<thread> threads;
+    threads.reserve(num_workers);
+    for (size_t w = 0; w < num_workers; ++w) {
+        threads.emplace_back([&, w] {
+            SimLogRedirect log(nullptr);
+            size_t job;
+            while (remaining.load(memory_order_acquire) > 0) {
+                bool found = queues[w].pop_front(job);
+                for (size_t k = 1; !found && k < num_workers; ++k) {                    // Roba empezando por el vecino
+                    found = queues[(w + k) % num_workers].steal_back(job);
+                }
+                if (!found) break;                                                      // Las colas solo se vacían: no queda nada
+
+                results[job] = run_job(jobs_[job]);
+                results[job].worker = static_cast<int>(w);
+                remaining.fetch_sub(1, memory_order_acq_rel);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    return results;
+}
+
+
+SweepResult SweepRunner::run_job(const SweepJob& job) {
+    SweepResult result;
+    result.job = job;
+    SimSystem system(job.config);
+    EventEngine engine(system, job.latency);
+    result.run = engine.run(*job.trace);
+    result.totals = system.totals();
+    result.bus_transactions = system.interconnect().get_completed_transactions();
+    result.snoop_messages = static_cast<uint64_t>(system.interconnect().get_snoop_messages());
+    result.snoop_filtered = system.interconnect().get_filtered_snoops();
+    result.access_mean_cycles = engine.access_latency().mean();
+    result.access_p99_cycles = engine.access_latency().percentile(99);
+    return result;
+}
+
+
+void write_sweep_csv(ostream& os, const vector<SweepResult>& results) {
+    os << "workload,protocol,coherence,pes,banks,mshrs,cache_lines,ops,cycles,bus_busy_cycles,"
+          "bus_tx_per_op,messages_per_op,snoops_per_op,filtered_snoops_per_op,access_mean_cycles,access_p99_cycles,"
+          "miss_ratio,seconds,worker\n";
+    for (const SweepResult& r : results) {
+        const SimConfig& c = r.job.config;
+        double ops = static_cast<double>(r.run.operations);
+        os << r.job.workload << "," << protocol_kind_name(c.protocol) << "," << coherence_mode_name(c.coherence_mode)
+           << "," << c.num_pes << "," << c.num_banks << "," << c.mshrs_per_pe << "," << c.cache_lines
+           << "," << r.run.operations << "," << r.run.cycles << "," << r.run.bus_busy_cycles
+           << "," << (ops ? r.bus_transactions / ops : 0.0) << "," << (ops ? r.totals.messages / ops : 0.0)
+           << "," << (ops ? r.snoop_messages / ops : 0.0) << "," << (ops ? r.snoop_filtered / ops : 0.0)
+           << "," << r.access_mean_cycles << "," << r.access_p99_cycles
+           << "," << r.totals.miss_ratio() << "," << r.run.seconds << "," << r.worker << "\n";
+    }
+}
+
+
+bool write_sweep_csv(const string& path, const vector<SweepResult>& results) {
+    ofstream out(path);
+    if (!out) {
+        cerr << "[Sweep] No se pudo abrir " << path << endl;
+        return false;
+    }
+    write_sweep_csv(out, results);
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,67 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "event_engine.h"
+#include "sim_system.h"
+#include "../Workload/workload_trace.h"
+
+using namespace std;
+
+// Una simulación del barrido: la carga (compartida, solo lectura) y la configuración del sistema
+struct SweepJob {
+    string workload;                                                                    // Nombre para la tabla de resultados
+    const WorkloadTrace* trace;
+    SimConfig config;
+    LatencyModel latency;
+};
+
+struct SweepResult {
+    SweepJob job;
+    EventSimResult run;
+    SimTotals totals;
+    uint64_t bus_transactions = 0;
+    uint64_t snoop_messages = 0;                                                        // Consultas enviadas a otros PEs
+    uint64_t snoop_filtered = 0;                                                        // SNOOP: consultas de difusión evitadas
+    double access_mean_cycles = 0.0;
+    uint64_t access_p99_cycles = 0;
+    int worker = -1;                                                                    // Hilo que la ejecutó
+};
+
+
+// Ejecuta muchas simulaciones independientes en un proceso. Cada trabajo crea su propio SimSystem
+// (memoria, cachés, interconnect, controladores) y lo corre con el motor de eventos, en un solo hilo
+// y con bus INLINE, así el paralelismo lo pone solo el pool: un trabajador por núcleo, cada uno con
+// su cola; el que se queda sin trabajo roba del final de la cola de otro. Las cargas se comparten
+// entre trabajos sin copiarse. La bitácora de cada corrida se descarta para no mezclarse en cout.
+// En INLINE no hay cola de banco, así que SimConfig::queue_depth no tiene efecto y la tabla no lo
+// incluye: el motor serializa las transacciones de cada banco sin límite de solicitudes en espera.
+class SweepRunner {
+public:
+    explicit SweepRunner(size_t workers = 0);                                           // 0: núcleos del host
+
+    size_t add(const string& workload, const WorkloadTrace& trace, const SimConfig& config,
+               const LatencyModel& latency = LatencyModel{});
+    size_t size() const { return jobs_.size(); }
+    size_t workers() const { return workers_; }
+
+    // Resultados en el orden en que se agregaron los trabajos
+    vector<SweepResult> run();
+
+private:
+    size_t workers_;
+    vector<SweepJob> jobs_;
+
+    static SweepResult run_job(const SweepJob& job);
+};
+
+// Tabla consolidada: una fila por simulación
+void write_sweep_csv(ostream& os, const vector<SweepResult>& results);
+bool write_sweep_csv(const string& path, const vector<SweepResult>& results);
+
+#endif // SWEEP_H
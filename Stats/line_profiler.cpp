@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "line_profiler.h"
+
+using namespace std;
+
+namespace {
+
+uint64_t pe_bit(int pe_id) {
+    return uint64_t(1) << (pe_id % 64);
+}
+
+}
+
+
+// Con período 2^k se muestrean los bloques cuyo hash multiplicativo tiene los k bits altos en cero
+LineProfiler::LineProfiler(int num_pes, const LineProfilerConfig& config)
+    : num_pes_(max(num_pes, 1)), config_(config), slot_(NUM_BLOCKS, -1) {
+    int bits = 0;
+    while ((size_t(1) << bits) < max<size_t>(config_.sample_period, 1) && bits < 16) bits++;
+    config_.sample_period = size_t(1) << bits;
+
+    for (size_t block = 0; block < NUM_BLOCKS; ++block) {
+        uint32_t hash = static_cast<uint32_t>(block + 1) * 2654435761u;                 // +1: el bloque 0 no queda siempre adentro
+        if (bits == 0 || (hash >> (32 - bits)) == 0) {
+            slot_[block] = static_cast<int32_t>(blocks_.size());
+            blocks_.push_back(block);
+        }
+    }
+    lines_ = make_unique<LineCounters[]>(blocks_.size());
+    cells_ = make_unique<Cell[]>(blocks_.size() * num_pes_);
+}
+
+
+// ==================================================================================== EVENTOS ===
+
+
+// Miss del PE (dentro de su transacción, antes de instalar la línea): si una escritura de otro PE le
+// había invalidado la copia es un miss de coherencia, verdadero o falso compartido según la palabra
+void LineProfiler::on_miss(int pe_id, MessageType type, size_t address, bool from_cache) {
+    int32_t slot = slot_[block_of(address)];
+    if (slot < 0) return;
+    LineCounters& line = lines_[slot];
+    size_t word = address % WORDS_PER_LINE;
+    (type == WRITE_MISS ? line.write_misses : line.read_misses).fetch_add(1, memory_order_relaxed);
+    if (from_cache) line.cache_to_cache.fetch_add(1, memory_order_relaxed);
+    line.word_misses[word].fetch_add(1, memory_order_relaxed);
+
+    Cell& c = cell(slot, pe_id);
+    c.misses.fetch_add(1, memory_order_relaxed);
+    uint8_t lost = c.lost_words.exchange(0, memory_order_relaxed);
+    if (!(lost & WAITING)) return;                                                      // Miss frío o de capacidad
+    line.invalidated.fetch_and(~pe_bit(pe_id), memory_order_relaxed);
+    (lost & (1u << word) ? line.true_sharing : line.false_sharing).fetch_add(1, memory_order_relaxed);
+}
+
+
+void LineProfiler::on_upgrade(int /*pe_id*/, size_t address) {
+    int32_t slot = slot_[block_of(address)];
+    if (slot < 0) return;
+    lines_[slot].upgrades.fetch_add(1, memory_order_relaxed);
+}
+
+
+void LineProfiler::on_invalidate(int target_pe, size_t address) {
+    int32_t slot = slot_[block_of(address)];
+    if (slot < 0) return;
+    LineCounters& line = lines_[slot];
+    line.invalidations.fetch_add(1, memory_order_relaxed);
+    line.word_invalidations[address % WORDS_PER_LINE].fetch_add(1, memory_order_relaxed);
+
+    Cell& c = cell(slot, target_pe);
+    c.invalidations.fetch_add(1, memory_order_relaxed);
+    c.lost_words.store(WAITING, memory_order_relaxed);
+    line.invalidated.fetch_or(pe_bit(target_pe), memory_order_relaxed);
+}
+
+
+// Escritura aplicada en la caché del PE (hit en E/M o destino de un MSHR); se anota en los PEs que
+// esperan su miss de coherencia
+void LineProfiler::on_write(int pe_id, size_t address) {
+    int32_t slot = slot_[block_of(address)];
+    if (slot < 0) return;
+    LineCounters& line = lines_[slot];
+    size_t word = address % WORDS_PER_LINE;
+    line.word_writes[word].fetch_add(1, memory_order_relaxed);
+    line.word_writers[word].fetch_or(pe_bit(pe_id), memory_order_relaxed);
+
+    uint64_t waiting = line.invalidated.load(memory_order_relaxed) & ~pe_bit(pe_id);
+    while (waiting) {
+        int bit = __builtin_ctzll(waiting);
+        waiting &= waiting - 1;
+        for (int pe = bit; pe < num_pes_; pe += 64) {
+            if (pe != pe_id) cell(slot, pe).lost_words.fetch_or(static_cast<uint8_t>(1u << word), memory_order_relaxed);
+        }
+    }
+}
+
+
+void LineProfiler::on_queue_delay(size_t address, uint64_t ns) {
+    int32_t slot = slot_[block_of(address)];
+    if (slot < 0) return;
+    lines_[slot].queue_delay_ns.fetch_add(ns, memory_order_relaxed);
+    lines_[slot].transactions.fetch_add(1, memory_order_relaxed);
+}
+
+
+void LineProfiler::reset() {
+    for (size_t slot = 0; slot < blocks_.size(); ++slot) {
+        LineCounters& line = lines_[slot];
+        for (atomic<uint64_t>* counter : {&line.read_misses, &line.write_misses, &line.upgrades, &line.invalidations,
+                                          &line.cache_to_cache, &line.false_sharing, &line.true_sharing,
+                                          &line.queue_delay_ns, &line.transactions, &line.invalidated}) {
+            counter->store(0, memory_order_relaxed);
+        }
+        for (size_t w = 0; w < WORDS_PER_LINE; ++w) {
+            line.word_writes[w].store(0, memory_order_relaxed);
+            line.word_misses[w].store(0, memory_order_relaxed);
+            line.word_invalidations[w].store(0, memory_order_relaxed);
+            line.word_writers[w].store(0, memory_order_relaxed);
+        }
+    }
+    for (size_t i = 0; i < blocks_.size() * num_pes_; ++i) {
+        cells_[i].misses.store(0, memory_order_relaxed);
+        cells_[i].invalidations.store(0, memory_order_relaxed);
+        cells_[i].lost_words.store(0, memory_order_relaxed);
+    }
+}
+
+
+// ==================================================================================== REPORTES ===
+
+
+LineReport LineProfiler::report(int32_t slot) const {
+    const LineCounters& line = lines_[slot];
+    LineReport r;
+    r.block = blocks_[slot];
+    r.read_misses = line.read_misses.load(memory_order_relaxed);
+    r.write_misses = line.write_misses.load(memory_order_relaxed);
+    r.upgrades = line.upgrades.load(memory_order_relaxed);
+    r.invalidations = line.invalidations.load(memory_order_relaxed);
+    r.cache_to_cache = line.cache_to_cache.load(memory_order_relaxed);
+    r.false_sharing_misses = line.false_sharing.load(memory_order_relaxed);
+    r.true_sharing_misses = line.true_sharing.load(memory_order_relaxed);
+    r.queue_delay_ns = line.queue_delay_ns.load(memory_order_relaxed);
+    r.transactions = line.transactions.load(memory_order_relaxed);
+
+    uint64_t writers = 0;
+    for (size_t w = 0; w < WORDS_PER_LINE; ++w) {
+        r.word_writes[w] = line.word_writes[w].load(memory_order_relaxed);
+        r.word_misses[w] = line.word_misses[w].load(memory_order_relaxed);
+        r.word_invalidations[w] = line.word_invalidations[w].load(memory_order_relaxed);
+        uint64_t mask = line.word_writers[w].load(memory_order_relaxed);
+        writers |= mask;
+        if (__builtin_popcountll(mask) > 1) r.shared_words++;
+    }
+    r.writers = __builtin_popcountll(writers);
+    return r;
+}
+
+
+vector<LineReport> LineProfiler::top_lines(size_t n) const {
+    vector<LineReport> reports;
+    for (size_t slot = 0; slot < blocks_.size(); ++slot) {
+        LineReport r = report(static_cast<int32_t>(slot));
+        if (r.coherence_events() > 0) reports.push_back(r);
+    }
+    auto hotter = [](const LineReport& a, const LineReport& b) {
+        return a.coherence_events() != b.coherence_events() ? a.coherence_events() > b.coherence_events() : a.block < b.block;
+    };
+    n = min(n, reports.size());
+    partial_sort(reports.begin(), reports.begin() + n, reports.end(), hotter);
+    reports.resize(n);
+    return reports;
+}
+
+
+void LineProfiler::print_top_lines(ostream& os, size_t n) const {
+    vector<LineReport> top = top_lines(n);
+    os << "Líneas con más eventos de coherencia: " << top.size() << " de " << blocks_.size() << " perfiladas (muestreo 1/"
+       << config_.sample_period << ")" << endl;
+    for (const LineReport& r : top) {
+        os << "  bloque " << r.block << " (dirección " << r.block * WORDS_PER_LINE << "): " << r.coherence_events()
+           << " eventos, misses " << r.read_misses << " R / " << r.write_misses << " W, upgrades " << r.upgrades
+           << ", invalidaciones " << r.invalidations << ", coherencia " << r.true_sharing_misses << " verdadero / "
+           << r.false_sharing_misses << " falso, espera media "
+           << (r.transactions ? r.queue_delay_ns / r.transactions : 0) << " ns, escrituras por palabra [";
+        for (size_t w = 0; w < WORDS_PER_LINE; ++w) os << (w ? " " : "") << r.word_writes[w];
+        os << "], " << r.writers << " escritores" << (r.false_sharing() ? "  <- FALSO COMPARTIDO" : "") << endl;
+    }
+}
+
+
+void LineProfiler::write_top_lines_csv(ostream& os, size_t n) const {
+    os << "block,address,events,read_misses,write_misses,upgrades,invalidations,cache_to_cache,"
+          "true_sharing_misses,false_sharing_misses,queue_delay_mean_ns,writers,shared_words,false_sharing";
+    for (const char* column : {"writes", "misses", "invalidations"}) {
+        for (size_t w = 0; w < WORDS_PER_LINE; ++w) os << ",word" << w << "_" << column;
+    }
+    os << "\n";
+
+    for (const LineReport& r : top_lines(n)) {
+        os << r.block << "," << r.block * WORDS_PER_LINE << "," << r.coherence_events() << "," << r.read_misses
+           << "," << r.write_misses << "," << r.upgrades << "," << r.invalidations << "," << r.cache_to_cache
+           << "," << r.true_sharing_misses << "," << r.false_sharing_misses
+           << "," << (r.transactions ? static_cast<double>(r.queue_delay_ns) / r.transactions : 0.0)
+           << "," << r.writers << "," << r.shared_words << "," << (r.false_sharing() ? 1 : 0);
+        for (const auto* words : {&r.word_writes, &r.word_misses, &r.word_invalidations}) {
+            for (uint64_t value : *words) os << "," << value;
+        }
+        os << "\n";
+    }
+}
+
+
+void LineProfiler::write_heatmap_csv(ostream& os) const {
+    os << "block,pe,misses,invalidations\n";
+    for (size_t slot = 0; slot < blocks_.size(); ++slot) {
+        for (int pe = 0; pe < num_pes_; ++pe) {
+            const Cell& c = cell(static_cast<int32_t>(slot), pe);
+            uint32_t misses = c.misses.load(memory_order_relaxed);
+            uint32_t invalidations = c.invalidations.load(memory_order_relaxed);
+            if (misses || invalidations) os << blocks_[slot] << "," << pe << "," << misses << "," << invalidations << "\n";
+        }
+    }
+}
+
+
+bool LineProfiler::export_top_lines_csv(const string& path, size_t n) const {
+    ofstream out(path);
+    if (!out) {
+        cerr << "[LineProfiler] No se pudo abrir " << path << endl;
+        return false;
+    }
+    write_top_lines_csv(out, n);
+    return static_cast<bool>(out);
+}
+
+
+bool LineProfiler::export_heatmap_csv(const string& path) const {
+    ofstream out(path);
+    if (!out) {
+        cerr << "[LineProfiler] No se pudo abrir " << path << endl;
+        return false;
+    }
+    write_heatmap_csv(out);
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,122 @@
+#ifndef LINE_PROFILER_H
+#define LINE_PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "../Interconnect/bus_types.h"
+
+using namespace std;
+
+struct LineProfilerConfig {
+    size_t sample_period = 1;                                                           // 1: todas las líneas; si no, ~1 de cada N (potencia de dos)
+};
+
+
+// Resumen de una línea perfilada (ver LineProfiler::top_lines)
+struct LineReport {
+    size_t block = 0;
+    uint64_t read_misses = 0;
+    uint64_t write_misses = 0;
+    uint64_t upgrades = 0;
+    uint64_t invalidations = 0;                                                         // Copias invalidadas por escrituras de otros PEs
+    uint64_t cache_to_cache = 0;
+    uint64_t false_sharing_misses = 0;
+    uint64_t true_sharing_misses = 0;
+    uint64_t queue_delay_ns = 0;                                                        // Suma de esperas en cola de sus transacciones
+    uint64_t transactions = 0;
+    array<uint64_t, WORDS_PER_LINE> word_writes{};
+    array<uint64_t, WORDS_PER_LINE> word_misses{};
+    array<uint64_t, WORDS_PER_LINE> word_invalidations{};                               // Por la palabra que escribió quien invalidó
+    int writers = 0;                                                                    // PEs distintos que escribieron (módulo 64)
+    int shared_words = 0;                                                               // Palabras escritas por más de un PE
+
+    uint64_t coherence_events() const { return read_misses + write_misses + upgrades + invalidations; }
+    // Varios PEs escriben y la mayoría de los misses de coherencia son por palabras que el PE no usa
+    bool false_sharing() const { return writers >= 2 && false_sharing_misses > true_sharing_misses; }
+};
+
+
+// Perfil de contención por línea de caché. El Interconnect le informa los misses, UPGRADEs,
+// invalidaciones y esperas en cola de cada transacción, y los MESIController cada escritura aplicada;
+// todo se atribuye al bloque y a la palabra dentro de la línea, y por (línea, PE) para el mapa de calor.
+//
+// Falso compartido: cuando una escritura invalida la copia de un PE, el PE queda a la espera de su
+// próximo miss a esa línea y se anotan las palabras que escriben los demás mientras tanto. Ese miss
+// es de coherencia; es falso compartido si la palabra que pide no está entre las anotadas.
+//
+// Muestreo: con sample_period > 1 solo se perfilan las líneas elegidas por un hash del bloque. Las
+// líneas elegidas tienen su perfil completo y el resto sale con una consulta a una tabla; la memoria
+// es proporcional a las líneas muestreadas. Los contadores son atómicos relajados: vale con varios
+// hilos y las transacciones de un mismo bloque ya llegan serializadas por su banco.
+class LineProfiler {
+public:
+    LineProfiler(int num_pes, const LineProfilerConfig& config = LineProfilerConfig{});
+
+    bool sampled(size_t address) const { return slot_[block_of(address)] >= 0; }
+
+    // Eventos; se ignoran en líneas no muestreadas
+    void on_miss(int pe_id, MessageType type, size_t address, bool from_cache);
+    void on_upgrade(int pe_id, size_t address);
+    void on_invalidate(int target_pe, size_t address);                                 // address: la palabra que escribe quien invalida
+    void on_write(int pe_id, size_t address);
+    void on_queue_delay(size_t address, uint64_t ns);
+    void reset();
+
+    const LineProfilerConfig& config() const { return config_; }
+    size_t sampled_lines() const { return blocks_.size(); }
+
+    // Las n líneas con más eventos de coherencia, de mayor a menor
+    vector<LineReport> top_lines(size_t n) const;
+
+    void print_top_lines(ostream& os, size_t n) const;
+    void write_top_lines_csv(ostream& os, size_t n) const;
+    void write_heatmap_csv(ostream& os) const;                                          // Una fila por (línea, PE) con actividad
+    bool export_top_lines_csv(const string& path, size_t n) const;
+    bool export_heatmap_csv(const string& path) const;
+
+private:
+    struct alignas(64) LineCounters {
+        atomic<uint64_t> read_misses{0};
+        atomic<uint64_t> write_misses{0};
+        atomic<uint64_t> upgrades{0};
+        atomic<uint64_t> invalidations{0};
+        atomic<uint64_t> cache_to_cache{0};
+        atomic<uint64_t> false_sharing{0};
+        atomic<uint64_t> true_sharing{0};
+        atomic<uint64_t> queue_delay_ns{0};
+        atomic<uint64_t> transactions{0};
+        array<atomic<uint32_t>, WORDS_PER_LINE> word_writes{};
+        array<atomic<uint32_t>, WORDS_PER_LINE> word_misses{};
+        array<atomic<uint32_t>, WORDS_PER_LINE> word_invalidations{};
+        array<atomic<uint64_t>, WORDS_PER_LINE> word_writers{};                         // Máscara de PEs (módulo 64)
+        atomic<uint64_t> invalidated{0};                                                // PEs esperando su miss de coherencia
+    };
+
+    struct Cell {                                                                       // (línea, PE)
+        atomic<uint32_t> misses{0};
+        atomic<uint32_t> invalidations{0};
+        atomic<uint8_t> lost_words{0};                                                  // Bit 7: esperando; bits 0-3: palabras escritas por otros
+    };
+
+    static constexpr uint8_t WAITING = 0x80;
+
+    int num_pes_;
+    LineProfilerConfig config_;
+    vector<int32_t> slot_;                                                              // Bloque -> línea perfilada, -1 sin muestrear
+    vector<size_t> blocks_;                                                             // Línea perfilada -> bloque
+    unique_ptr<LineCounters[]> lines_;
+    unique_ptr<Cell[]> cells_;
+
+    Cell& cell(int32_t slot, int pe_id) { return cells_[static_cast<size_t>(slot) * num_pes_ + pe_id]; }
+    const Cell& cell(int32_t slot, int pe_id) const { return cells_[static_cast<size_t>(slot) * num_pes_ + pe_id]; }
+    LineReport report(int32_t slot) const;
+};
+
+#endif // LINE_PROFILER_H
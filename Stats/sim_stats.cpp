@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "sim_stats.h"
+
+using namespace std;
+
+// ==================================================================================== HISTOGRAMA ===
+
+
+int LatencyHistogram::bucket_index(uint64_t value) {
+    if (value < static_cast<uint64_t>(SUB_BUCKETS)) return static_cast<int>(value);
+
+    int exponent = 63 - __builtin_clzll(value);                                         // Bit más significativo
+    if (exponent >= MAX_EXPONENT) return NUM_BUCKETS - 1;
+    int shift = exponent - SUB_BUCKET_BITS;                                             // value >> shift queda en [16, 32)
+    int sub = static_cast<int>(value >> shift) - SUB_BUCKETS;
+    return (shift + 1) * SUB_BUCKETS + sub;
+}
+
+
+uint64_t LatencyHistogram::bucket_upper_bound(int index) {
+    if (index < SUB_BUCKETS) return static_cast<uint64_t>(index);
+    int shift = index / SUB_BUCKETS - 1;
+    uint64_t sub = static_cast<uint64_t>(index % SUB_BUCKETS) + SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+
+uint64_t LatencyHistogram::count() const {
+    uint64_t total = 0;
+    for (const auto& bucket : buckets_) total += bucket.load(memory_order_relaxed);
+    return total;
+}
+
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n ? static_cast<double>(sum_.load(memory_order_relaxed)) / n : 0.0;
+}
+
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+    uint64_t target = static_cast<uint64_t>(p / 100.0 * n + 0.5);
+    if (target == 0) target = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += buckets_[i].load(memory_order_relaxed);
+        if (seen >= target) return min(bucket_upper_bound(i), max());
+    }
+    return max();
+}
+
+
+void LatencyHistogram::merge_into(vector<uint64_t>& totals) const {
+    totals.resize(NUM_BUCKETS, 0);
+    for (int i = 0; i < NUM_BUCKETS; ++i) totals[i] += buckets_[i].load(memory_order_relaxed);
+}
+
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) bucket.store(0, memory_order_relaxed);
+    sum_.store(0, memory_order_relaxed);
+    max_.store(0, memory_order_relaxed);
+}
+
+
+// ==================================================================================== ESTADÍSTICAS ===
+
+
+SimStats::SimStats(int num_pes) {
+    pes_.reserve(num_pes);
+    for (int i = 0; i < num_pes; ++i) pes_.push_back(make_unique<PeStats>());
+}
+
+
+void SimStats::reset() {
+    for (auto& pe : pes_) {
+        pe->read_hits = 0;
+        pe->read_misses = 0;
+        pe->write_hits = 0;
+        pe->write_misses = 0;
+        pe->invalidations_received = 0;
+        pe->write_backs = 0;
+        pe->cache_to_cache = 0;
+        pe->memory_fills = 0;
+        pe->flushes = 0;
+        pe->silent_upgrades = 0;
+        pe->upgrade_fallbacks = 0;
+        pe->mshr_merges = 0;
+        pe->mshr_full_stalls = 0;
+        pe->prefetch_issued = 0;
+        pe->prefetch_useful = 0;
+        pe->prefetch_late = 0;
+        pe->prefetch_invalidated = 0;
+        pe->prefetch_throttled = 0;
+        pe->atomic_rmws = 0;
+        pe->cas_failures = 0;
+        pe->store_conditionals = 0;
+        pe->sc_failures = 0;
+        for (auto& sent : pe->messages_sent) sent = 0;
+        pe->queue_delay_ns.reset();
+        pe->service_ns.reset();
+    }
+}
+
+
+namespace {
+
+void write_histogram_json(ostream& os, const LatencyHistogram& h) {
+    os << "{\"count\":" << h.count() << ",\"mean\":" << h.mean()
+       << ",\"p50\":" << h.percentile(50) << ",\"p90\":" << h.percentile(90)
+       << ",\"p99\":" << h.percentile(99) << ",\"max\":" << h.max() << "}";
+}
+
+}
+
+
+void SimStats::write_json(ostream& os, const Summary& summary) const {
+    os << "{\n  \"summary\": {";
+    for (size_t i = 0; i < summary.size(); ++i) {
+        os << (i ? ", " : "") << "\"" << summary[i].first << "\": " << summary[i].second;
+    }
+    os << "},\n  \"pes\": [\n";
+
+    for (size_t id = 0; id < pes_.size(); ++id) {
+        const PeStats& pe = *pes_[id];
+        os << "    {\"pe\": " << id
+           << ", \"read_hits\": " << pe.read_hits << ", \"read_misses\": " << pe.read_misses
+           << ", \"write_hits\": " << pe.write_hits << ", \"write_misses\": " << pe.write_misses
+           << ", \"invalidations_received\": " << pe.invalidations_received
+           << ", \"write_backs\": " << pe.write_backs
+           << ", \"cache_to_cache\": " << pe.cache_to_cache << ", \"memory_fills\": " << pe.memory_fills
+           << ", \"flushes\": " << pe.flushes
+           << ", \"silent_upgrades\": " << pe.silent_upgrades << ", \"upgrade_fallbacks\": " << pe.upgrade_fallbacks
+           << ", \"mshr_merges\": " << pe.mshr_merges << ", \"mshr_full_stalls\": " << pe.mshr_full_stalls
+           << ", \"prefetch_issued\": " << pe.prefetch_issued << ", \"prefetch_useful\": " << pe.prefetch_useful
+           << ", \"prefetch_late\": " << pe.prefetch_late << ", \"prefetch_invalidated\": " << pe.prefetch_invalidated
+           << ", \"prefetch_throttled\": " << pe.prefetch_throttled
+           << ", \"atomic_rmws\": " << pe.atomic_rmws << ", \"cas_failures\": " << pe.cas_failures
+           << ", \"store_conditionals\": " << pe.store_conditionals << ", \"sc_failures\": " << pe.sc_failures
+           << ", \"messages\": {";
+        for (size_t t = 0; t < NUM_MESSAGE_TYPES; ++t) {
+            os << (t ? ", " : "") << "\"" << message_type_name(static_cast<MessageType>(t)) << "\": " << pe.messages_sent[t];
+        }
+        os << "}, \"queue_delay_ns\": ";
+        write_histogram_json(os, pe.queue_delay_ns);
+        os << ", \"service_ns\": ";
+        write_histogram_json(os, pe.service_ns);
+        os << "}" << (id + 1 < pes_.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+
+void SimStats::write_csv(ostream& os) const {
+    os << "pe,read_hits,read_misses,write_hits,write_misses,invalidations_received,write_backs,cache_to_cache,memory_fills,flushes,silent_upgrades,upgrade_fallbacks,mshr_merges,mshr_full_stalls"
+          ",prefetch_issued,prefetch_useful,prefetch_late,prefetch_invalidated,prefetch_throttled"
+          ",atomic_rmws,cas_failures,store_conditionals,sc_failures";
+    for (size_t t = 0; t < NUM_MESSAGE_TYPES; ++t) os << ",sent_" << message_type_name(static_cast<MessageType>(t));
+    os << ",queue_delay_mean_ns,queue_delay_p99_ns,service_mean_ns,service_p99_ns\n";
+
+    for (size_t id = 0; id < pes_.size(); ++id) {
+        const PeStats& pe = *pes_[id];
+        os << id << "," << pe.read_hits << "," << pe.read_misses << "," << pe.write_hits << "," << pe.write_misses
+           << "," << pe.invalidations_received << "," << pe.write_backs << "," << pe.cache_to_cache << "," << pe.memory_fills
+           << "," << pe.flushes << "," << pe.silent_upgrades << "," << pe.upgrade_fallbacks
+           << "," << pe.mshr_merges << "," << pe.mshr_full_stalls
+           << "," << pe.prefetch_issued << "," << pe.prefetch_useful << "," << pe.prefetch_late
+           << "," << pe.prefetch_invalidated << "," << pe.prefetch_throttled
+           << "," << pe.atomic_rmws << "," << pe.cas_failures << "," << pe.store_conditionals << "," << pe.sc_failures;
+        for (size_t t = 0; t < NUM_MESSAGE_TYPES; ++t) os << "," << pe.messages_sent[t];
+        os << "," << pe.queue_delay_ns.mean() << "," << pe.queue_delay_ns.percentile(99)
+           << "," << pe.service_ns.mean() << "," << pe.service_ns.percentile(99) << "\n";
+    }
+}
+
+
+bool SimStats::export_json(const string& path, const Summary& summary) const {
+    ofstream out(path);
+    if (!out) {
+        cerr << "[Stats] No se pudo abrir " << path << endl;
+        return false;
+    }
+    write_json(out, summary);
+    return true;
+}
+
+
+bool SimStats::export_csv(const string& path) const {
+    ofstream out(path);
+    if (!out) {
+        cerr << "[Stats] No se pudo abrir " << path << endl;
+        return false;
+    }
+    write_csv(out);
+    return true;
+}
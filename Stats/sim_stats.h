@@ -0,0 +1,104 @@
+#ifndef SIM_STATS_H
+#define SIM_STATS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../Interconnect/bus_types.h"
+
+using namespace std;
+
+// Histograma log-lineal al estilo HDR: 16 sub-cubetas por potencia de dos (~6% de error relativo).
+// record() es un único fetch_add relajado, apto para la ruta crítica.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_EXPONENT = 44;                                             // ~4.8 horas en ns
+    static constexpr int NUM_BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void record(uint64_t value) {
+        buckets_[bucket_index(value)].fetch_add(1, memory_order_relaxed);
+        sum_.fetch_add(value, memory_order_relaxed);
+        uint64_t prev = max_.load(memory_order_relaxed);
+        while (value > prev && !max_.compare_exchange_weak(prev, value, memory_order_relaxed)) {}
+    }
+
+    uint64_t count() const;
+    uint64_t max() const { return max_.load(memory_order_relaxed); }
+    double mean() const;
+    uint64_t percentile(double p) const;                                                // p en [0, 100]
+    void merge_into(vector<uint64_t>& totals) const;
+    void reset();
+
+    static int bucket_index(uint64_t value);
+    static uint64_t bucket_upper_bound(int index);
+
+private:
+    array<atomic<uint64_t>, NUM_BUCKETS> buckets_{};
+    atomic<uint64_t> sum_{0};
+    atomic<uint64_t> max_{0};
+};
+
+
+// Contadores de un PE; alineados a línea de caché para que cada PE escriba en la suya
+struct alignas(64) PeStats {
+    atomic<uint64_t> read_hits{0};
+    atomic<uint64_t> read_misses{0};
+    atomic<uint64_t> write_hits{0};
+    atomic<uint64_t> write_misses{0};
+    atomic<uint64_t> invalidations_received{0};                                         // INVALIDATE recibidos desde el bus
+    atomic<uint64_t> write_backs{0};
+    atomic<uint64_t> cache_to_cache{0};                                                 // Misses servidos por otra caché
+    atomic<uint64_t> memory_fills{0};                                                   // Misses servidos por memoria
+    atomic<uint64_t> flushes{0};                                                        // Líneas sucias entregadas y escritas en memoria
+    atomic<uint64_t> silent_upgrades{0};                                                // Escrituras E -> M sin tráfico de bus
+    atomic<uint64_t> upgrade_fallbacks{0};                                              // UPGRADE que perdió la línea y se sirvió como WRITE_MISS
+    atomic<uint64_t> mshr_merges{0};                                                    // Misses secundarios fusionados en un MSHR en vuelo
+    atomic<uint64_t> mshr_full_stalls{0};                                               // Accesos que esperaron por falta de MSHR libre
+    atomic<uint64_t> prefetch_issued{0};                                                // READ_MISS de baja prioridad enviados por el prefetcher
+    atomic<uint64_t> prefetch_useful{0};                                                // Líneas prefetcheadas usadas por la demanda
+    atomic<uint64_t> prefetch_late{0};                                                  // La demanda llegó con el prefetch aún en vuelo
+    atomic<uint64_t> prefetch_invalidated{0};                                           // Invalidadas por otro PE antes de usarse
+    atomic<uint64_t> prefetch_throttled{0};                                             // Descartados por congestión o falta de MSHR
+    atomic<uint64_t> atomic_rmws{0};                                                    // fetch_add, exchange y compare_and_swap ejecutados
+    atomic<uint64_t> cas_failures{0};                                                   // compare_and_swap que no escribió
+    atomic<uint64_t> store_conditionals{0};
+    atomic<uint64_t> sc_failures{0};                                                    // Enlace perdido: el SC no escribió
+    array<atomic<uint64_t>, NUM_MESSAGE_TYPES> messages_sent{};
+
+    LatencyHistogram queue_delay_ns;                                                    // Encolado -> concesión del bus
+    LatencyHistogram service_ns;                                                        // Concesión -> fin de la transacción
+};
+
+
+// Estadísticas de una simulación: por PE y por tipo de mensaje, exportables al final de la corrida
+class SimStats {
+public:
+    explicit SimStats(int num_pes);
+
+    PeStats& pe(int pe_id) { return *pes_[pe_id]; }
+    const PeStats& pe(int pe_id) const { return *pes_[pe_id]; }
+    int num_pes() const { return static_cast<int>(pes_.size()); }
+
+    // Valores globales adicionales (tráfico, transacciones/s, ...) que acompañan la exportación
+    using Summary = vector<pair<string, double>>;
+
+    void write_json(ostream& os, const Summary& summary = {}) const;
+    void write_csv(ostream& os) const;
+    bool export_json(const string& path, const Summary& summary = {}) const;
+    bool export_csv(const string& path) const;
+
+    void reset();
+
+private:
+    vector<unique_ptr<PeStats>> pes_;
+};
+
+#endif // SIM_STATS_H
@@ -0,0 +1,76 @@
+// Prueba de la carga de trabajo: una WorkloadTrace debe rechazar dos flujos con el mismo pe_id, tanto
+// desde un buffer como al abrir el archivo, porque TraceReplayer lanza un hilo por flujo y dos hilos
+// sobre el mismo MESIController serían una carrera de datos. El importador de texto junta las líneas
+// de un PE en un solo flujo aunque aparezcan intercaladas.
+//
+// Uso: test_workload_trace [directorio_temporal=/tmp]
+//
+// Imprime una línea por caso (ok/FALLA) y termina con código distinto de cero si alguno falla.
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../Workload/workload_trace.h"
+
+using namespace std;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const string& name) {
+    cout << (condition ? "ok    " : "FALLA ") << name << endl;
+    if (!condition) failures++;
+}
+
+
+WorkloadStreamBuilder make_stream(int pe_id, size_t records) {
+    WorkloadStreamBuilder stream{pe_id, {}};
+    for (size_t i = 0; i < records; ++i) {
+        WorkloadRecord record{};
+        record.address = static_cast<uint16_t>(i);
+        record.op = (i % 2) ? WorkloadOp::WRITE : WorkloadOp::READ;
+        record.value = static_cast<double>(i);
+        stream.records.push_back(record);
+    }
+    return stream;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    string dir = argc > 1 ? argv[1] : "/tmp";
+
+    vector<WorkloadStreamBuilder> unique = {make_stream(0, 4), make_stream(1, 3), make_stream(2, 5)};
+    vector<WorkloadStreamBuilder> repeated = {make_stream(0, 4), make_stream(1, 3), make_stream(0, 2)};
+
+    WorkloadTrace trace;
+    check(trace.from_buffer(encode_workload(unique)) && trace.num_streams() == 3 && trace.total_records() == 12,
+          "buffer con pe_id distintos se carga");
+    check(!trace.from_buffer(encode_workload(repeated)) && !trace.is_open(),
+          "buffer con pe_id repetido se rechaza");
+
+    string unique_path = dir + "/test_workload_unique.bin";
+    string repeated_path = dir + "/test_workload_repeated.bin";
+    check(write_workload(unique_path, unique) && trace.open(unique_path) && trace.num_streams() == 3,
+          "archivo con pe_id distintos se abre");
+    check(write_workload(repeated_path, repeated) && !trace.open(repeated_path) && !trace.is_open(),
+          "archivo con pe_id repetido se rechaza");
+    remove(unique_path.c_str());
+    remove(repeated_path.c_str());
+
+    istringstream text("0 R 1\n1 W 2 3.5\n0 W 4 1.0\n1 R 2\n0 R 1\n");
+    vector<WorkloadStreamBuilder> parsed;
+    check(parse_text_workload(text, parsed) && parsed.size() == 2 && parsed[0].pe_id == 0 &&
+              parsed[0].records.size() == 3 && parsed[1].pe_id == 1 && parsed[1].records.size() == 2,
+          "texto intercalado queda en un flujo por PE");
+    check(trace.from_buffer(encode_workload(parsed)) && trace.num_streams() == 2,
+          "carga importada de texto se acepta");
+
+    cout << (failures ? "FALLAS: " + to_string(failures) : string("todo ok")) << endl;
+    return failures ? 1 : 0;
+}
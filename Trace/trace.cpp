@@ -0,0 +1,155 @@
+#include <chrono>
+
+#include "trace.h"
+
+using namespace std;
+
+namespace {
+
+uint64_t now_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+atomic<uint64_t> next_sink_id{1};                                                       // Identifica sumideros para la caché por hilo
+
+// Última cola usada por este hilo; evita buscar en el registro en cada emit
+struct LocalBufferCache {
+    uint64_t sink_id = 0;
+    void* buffer = nullptr;
+};
+
+thread_local LocalBufferCache tls_buffer;
+
+constexpr char kTraceMagic[8] = {'M', 'P', 'T', 'R', 'A', 'C', 'E', '1'};
+
+}
+
+
+ostream*& sim_log_target() {
+    thread_local ostream* target = &cout;
+    return target;
+}
+
+
+TraceSink::TraceSink(const string& path, size_t ring_capacity)
+    : ring_capacity_(ring_capacity), sink_id_(next_sink_id.fetch_add(1)), start_ns_(now_ns()) {
+
+    if (ring_capacity_ == 0 || (ring_capacity_ & (ring_capacity_ - 1)) != 0) {        // Redondea a potencia de dos
+        size_t pow2 = 1;
+        while (pow2 < ring_capacity_) pow2 <<= 1;
+        ring_capacity_ = pow2;
+    }
+
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        cerr << "[Trace] No se pudo abrir el archivo de trazas " << path << endl;
+        return;
+    }
+
+    uint32_t record_size = sizeof(TraceRecord);                                         // Encabezado: magic + tamaño de registro
+    fwrite(kTraceMagic, 1, sizeof(kTraceMagic), file_);
+    fwrite(&record_size, sizeof(record_size), 1, file_);
+
+    drain_thread_ = thread(&TraceSink::drain_loop, this);
+}
+
+
+TraceSink::~TraceSink() {
+    if (drain_thread_.joinable()) {
+        {
+            lock_guard<mutex> lock(drain_mutex_);
+            stop_ = true;
+        }
+        drain_cv_.notify_one();
+        drain_thread_.join();
+    }
+    if (file_) {
+        drain_once();                                                                   // Lo que quede tras detener el hilo
+        fclose(file_);
+    }
+}
+
+
+// ==================================================================================== PRODUCTORES ===
+
+
+void TraceSink::emit(TraceRecord record) {
+    if (!file_) return;
+
+    record.timestamp_ns = now_ns() - start_ns_;
+    if (!local_buffer()->ring.push(record)) {
+        dropped_.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+
+// Obtiene (o registra la primera vez) la cola del hilo actual para este sumidero
+TraceSink::ThreadBuffer* TraceSink::local_buffer() {
+    if (tls_buffer.sink_id == sink_id_) {
+        return static_cast<ThreadBuffer*>(tls_buffer.buffer);
+    }
+
+    thread_local vector<pair<uint64_t, ThreadBuffer*>> known;                           // Hilos que alternan entre sumideros
+    for (const auto& entry : known) {
+        if (entry.first == sink_id_) {
+            tls_buffer = {sink_id_, entry.second};
+            return entry.second;
+        }
+    }
+
+    ThreadBuffer* buffer;
+    {
+        lock_guard<mutex> lock(registry_mutex_);
+        buffers_.push_back(make_unique<ThreadBuffer>(ring_capacity_));
+        buffer = buffers_.back().get();
+    }
+    known.emplace_back(sink_id_, buffer);
+    tls_buffer = {sink_id_, buffer};
+    return buffer;
+}
+
+
+// ==================================================================================== CONSUMIDOR ===
+
+
+// Vacía todas las colas al archivo, retorna cuántos registros escribió
+size_t TraceSink::drain_once() {
+    TraceRecord batch[256];
+    size_t total = 0;
+
+    lock_guard<mutex> lock(registry_mutex_);
+    for (auto& buffer : buffers_) {
+        size_t count;
+        do {
+            count = 0;
+            while (count < 256 && buffer->ring.pop(batch[count])) count++;
+            if (count > 0) {
+                fwrite(batch, sizeof(TraceRecord), count, file_);
+                total += count;
+            }
+        } while (count == 256);
+    }
+
+    written_.fetch_add(total, memory_order_relaxed);
+    return total;
+}
+
+
+void TraceSink::drain_loop() {
+    unique_lock<mutex> lock(drain_mutex_);
+    while (!stop_) {
+        lock.unlock();
+        size_t drained = drain_once();
+        lock.lock();
+        if (drained == 0) {
+            drain_cv_.wait_for(lock, chrono::milliseconds(1), [&] { return stop_; });
+        }
+    }
+}
+
+
+void TraceSink::flush() {
+    if (!file_) return;
+    drain_once();
+    fflush(file_);
+}
@@ -0,0 +1,197 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// ==================================================================================== NIVEL DE TRAZA (COMPILACIÓN) ===
+
+// OFF: sin trazas. EVENTS: solo registros binarios. VERBOSE: además la bitácora de texto [VERIF-*].
+// Se fija con -DSIM_TRACE_LEVEL=n; por defecto VERBOSE en debug y EVENTS en release (NDEBUG).
+enum class TraceLevel : int {
+    OFF = 0,
+    EVENTS = 1,
+    VERBOSE = 2,
+};
+
+#ifndef SIM_TRACE_LEVEL
+#ifdef NDEBUG
+#define SIM_TRACE_LEVEL 1
+#else
+#define SIM_TRACE_LEVEL 2
+#endif
+#endif
+
+constexpr TraceLevel kTraceLevel = static_cast<TraceLevel>(SIM_TRACE_LEVEL);
+
+template <TraceLevel L>
+constexpr bool trace_enabled() {
+    return static_cast<int>(L) <= static_cast<int>(kTraceLevel);
+}
+
+// Destino de la bitácora del hilo actual (cout por defecto; nullptr la descarta). Cada sistema
+// simulado escribe en el destino de quien lo creó (ver Interconnect), así las corridas en paralelo
+// de un barrido no mezclan sus líneas en cout.
+ostream*& sim_log_target();
+
+// Cambia el destino de la bitácora del hilo mientras vive el objeto
+class SimLogRedirect {
+public:
+    explicit SimLogRedirect(ostream* target) : saved_(sim_log_target()) { sim_log_target() = target; }
+    ~SimLogRedirect() { sim_log_target() = saved_; }
+
+    SimLogRedirect(const SimLogRedirect&) = delete;
+    SimLogRedirect& operator=(const SimLogRedirect&) = delete;
+
+private:
+    ostream* saved_;
+};
+
+// Bitácora de texto de verificación: con nivel < VERBOSE la rama se descarta en compilación
+#define SIM_LOG(expr)                                                                   \
+    do {                                                                                \
+        if constexpr (trace_enabled<TraceLevel::VERBOSE>()) {                           \
+            if (ostream* sim_log_ = sim_log_target()) *sim_log_ << expr << '\n';        \
+        }                                                                               \
+    } while (0)
+
+
+// ==================================================================================== REGISTRO BINARIO ===
+
+enum class TraceEvent : uint8_t {
+    ACCESS_HIT,         // Acceso resuelto en caché privada
+    ACCESS_MISS,        // Acceso que requiere el bus
+    BUS_ENQUEUE,        // Mensaje encolado en el interconnect
+    BUS_GRANT,          // El PE obtiene el bus
+    BUS_COMPLETE,       // Transacción terminada
+    SNOOP,              // El interconnect consulta a otro PE
+    STATE_CHANGE,       // Transición de estado de coherencia de una línea (LineState)
+};
+
+constexpr uint8_t kNoState = 0xFF;                                                      // Estado desconocido / no aplica
+
+struct TraceRecord {
+    uint64_t timestamp_ns;                                                              // Desde la creación del TraceSink
+    uint32_t address;
+    int16_t pe_id;                                                                      // PE que origina el evento
+    int16_t target_pe;                                                                  // PE consultado en un snoop, -1 si no aplica
+    TraceEvent event;
+    uint8_t msg_type;                                                                   // MessageType
+    uint8_t from_state;                                                                 // LineState previo (0-5: I, S, E, M, O, F)
+    uint8_t to_state;                                                                   // LineState nuevo
+    uint32_t reserved;
+};
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord debe mantener el formato binario de 24 bytes");
+
+
+// Cola circular sin locks de un productor y un consumidor (capacidad potencia de dos)
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) : slots_(capacity), mask_(capacity - 1) {}
+
+    bool push(const T& item) {
+        size_t tail = tail_.load(memory_order_relaxed);
+        if (tail - head_.load(memory_order_acquire) > mask_) return false;              // Llena
+        slots_[tail & mask_] = item;
+        tail_.store(tail + 1, memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        size_t head = head_.load(memory_order_relaxed);
+        if (head == tail_.load(memory_order_acquire)) return false;                     // Vacía
+        item = slots_[head & mask_];
+        head_.store(head + 1, memory_order_release);
+        return true;
+    }
+
+private:
+    vector<T> slots_;
+    size_t mask_;
+    alignas(64) atomic<size_t> head_{0};
+    alignas(64) atomic<size_t> tail_{0};
+};
+
+
+// ==================================================================================== SUMIDERO DE TRAZAS ===
+
+// Cada hilo escribe en su propia cola SPSC; un hilo de fondo las vacía al archivo binario.
+// Si una cola se llena el registro se descarta (y se cuenta) para no frenar la simulación.
+class TraceSink {
+public:
+    explicit TraceSink(const string& path, size_t ring_capacity = 1 << 14);
+    ~TraceSink();
+
+    TraceSink(const TraceSink&) = delete;
+    TraceSink& operator=(const TraceSink&) = delete;
+
+    void emit(TraceRecord record);
+    void flush();
+
+    bool is_open() const { return file_ != nullptr; }
+    uint64_t written() const { return written_.load(memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(memory_order_relaxed); }
+
+private:
+    struct ThreadBuffer {
+        explicit ThreadBuffer(size_t capacity) : ring(capacity) {}
+        SpscRing<TraceRecord> ring;
+    };
+
+    ThreadBuffer* local_buffer();
+    size_t drain_once();
+    void drain_loop();
+
+    FILE* file_ = nullptr;
+    size_t ring_capacity_;
+    uint64_t sink_id_;
+    uint64_t start_ns_;
+
+    mutex registry_mutex_;
+    vector<unique_ptr<ThreadBuffer>> buffers_;
+
+    mutex drain_mutex_;
+    condition_variable drain_cv_;
+    bool stop_ = false;
+    thread drain_thread_;
+
+    atomic<uint64_t> written_{0};
+    atomic<uint64_t> dropped_{0};
+};
+
+
+// Emite un registro si el nivel compilado lo permite y hay sumidero conectado
+template <TraceLevel L = TraceLevel::EVENTS>
+inline void trace_event([[maybe_unused]] TraceSink* sink, [[maybe_unused]] TraceEvent event,
+                        [[maybe_unused]] int pe_id, [[maybe_unused]] int target_pe, [[maybe_unused]] size_t address,
+                        [[maybe_unused]] uint8_t msg_type, [[maybe_unused]] uint8_t from_state = kNoState,
+                        [[maybe_unused]] uint8_t to_state = kNoState) {
+    if constexpr (trace_enabled<L>()) {
+        if (sink) {
+            TraceRecord record{};
+            record.address = static_cast<uint32_t>(address);
+            record.pe_id = static_cast<int16_t>(pe_id);
+            record.target_pe = static_cast<int16_t>(target_pe);
+            record.event = event;
+            record.msg_type = msg_type;
+            record.from_state = from_state;
+            record.to_state = to_state;
+            sink->emit(record);
+        }
+    }
+}
+
+#endif // TRACE_H
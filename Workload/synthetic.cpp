@@ -0,0 +1,114 @@
+#include <algorithm>
+
+#include "synthetic.h"
+#include "../Interconnect/bus_types.h"
+
+using namespace std;
+
+namespace {
+
+// splitmix64: barato y reproducible, un estado por PE
+struct Rng {
+    uint64_t state;
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+// Tamaño de cada región para que regions regiones quepan en el espacio de direcciones de 16 bits
+size_t region_size(size_t requested, size_t regions) {
+    size_t limit = ADDRESS_SPACE_WORDS / max<size_t>(regions, 1);
+    return max(WORDS_PER_LINE, min(requested, limit));
+}
+
+WorkloadRecord make_record(WorkloadOp op, size_t address, double value, uint32_t think_ns) {
+    WorkloadRecord record{};
+    record.op = op;
+    record.address = static_cast<uint16_t>(address);
+    record.value = value;
+    record.think_ns = think_ns;
+    return record;
+}
+
+}
+
+
+const char* synthetic_pattern_name(SyntheticPattern pattern) {
+    static const char* const names[NUM_SYNTHETIC_PATTERNS] = {
+        "producer_consumer", "false_sharing", "true_sharing", "read_mostly", "private_streaming", "migratory",
+    };
+    return names[static_cast<size_t>(pattern)];
+}
+
+
+vector<WorkloadStreamBuilder> generate_synthetic(const SyntheticConfig& config) {
+    vector<WorkloadStreamBuilder> streams;
+    streams.reserve(config.num_pes);
+
+    for (int pe = 0; pe < config.num_pes; ++pe) {
+        WorkloadStreamBuilder stream{pe, {}};
+        stream.records.reserve(config.ops_per_pe);
+        Rng rng{config.seed ^ (0xD1B54A32D192ED03ull * static_cast<uint64_t>(pe + 1))};
+        auto mixed_op = [&] { return rng.uniform() < config.write_ratio ? WorkloadOp::WRITE : WorkloadOp::READ; };
+        auto push = [&](WorkloadOp op, size_t address, double value) {
+            stream.records.push_back(make_record(op, address, value, config.think_ns));
+        };
+
+        size_t n = config.ops_per_pe;
+        switch (config.pattern) {
+            case SyntheticPattern::PRODUCER_CONSUMER: {
+                size_t pairs = (static_cast<size_t>(config.num_pes) + 1) / 2;
+                size_t range = region_size(config.address_range, pairs);
+                size_t base = static_cast<size_t>(pe / 2) * range;
+                WorkloadOp op = (pe % 2 == 0) ? WorkloadOp::WRITE : WorkloadOp::READ;
+                for (size_t i = 0; i < n; ++i) push(op, base + i % range, double(i));
+                break;
+            }
+            case SyntheticPattern::FALSE_SHARING: {                                     // Con más de 4 PEs varias palabras se comparten de verdad
+                size_t word = static_cast<size_t>(pe) % WORDS_PER_LINE;
+                for (size_t i = 0; i < n; ++i) push(mixed_op(), word, double(i));
+                break;
+            }
+            case SyntheticPattern::TRUE_SHARING: {
+                for (size_t i = 0; i + 1 < n; i += 2) {
+                    push(WorkloadOp::READ, 0, 0.0);
+                    push(WorkloadOp::WRITE, 0, double(i));
+                }
+                break;
+            }
+            case SyntheticPattern::READ_MOSTLY: {
+                size_t range = region_size(config.address_range, 1);
+                for (size_t i = 0; i < n; ++i) push(mixed_op(), rng.next() % range, double(i));
+                break;
+            }
+            case SyntheticPattern::PRIVATE_STREAMING: {
+                size_t range = region_size(config.address_range, config.num_pes);
+                size_t base = static_cast<size_t>(pe) * range;
+                for (size_t i = 0; i < n; ++i) push(mixed_op(), base + i % range, double(i));
+                break;
+            }
+            case SyntheticPattern::MIGRATORY: {                                         // El objeto k lo toca el PE p en el paso k - p
+                size_t objects = region_size(config.address_range, 1) / WORDS_PER_LINE;
+                for (size_t i = 0; i + 1 < n; i += 2) {
+                    size_t address = ((i / 2 + static_cast<size_t>(pe)) % objects) * WORDS_PER_LINE;
+                    push(WorkloadOp::READ, address, 0.0);
+                    push(WorkloadOp::WRITE, address, double(i));
+                }
+                break;
+            }
+        }
+        streams.push_back(move(stream));
+    }
+    return streams;
+}
+
+
+bool make_synthetic_trace(const SyntheticConfig& config, WorkloadTrace& trace) {
+    return trace.from_buffer(encode_workload(generate_synthetic(config)));
+}
@@ -0,0 +1,40 @@
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "workload_trace.h"
+
+using namespace std;
+
+// Patrones clásicos de compartición para medir el escalamiento de la coherencia
+enum class SyntheticPattern {
+    PRODUCER_CONSUMER,                                                                  // Pares de PEs: uno escribe un buffer, el otro lo lee
+    FALSE_SHARING,                                                                      // Cada PE usa su palabra de una misma línea
+    TRUE_SHARING,                                                                       // Todos incrementan el mismo contador (lee + escribe)
+    READ_MOSTLY,                                                                        // Tabla compartida con pocas escrituras
+    PRIVATE_STREAMING,                                                                  // Cada PE recorre su propia región
+    MIGRATORY,                                                                          // Objetos que pasan de PE en PE (lee + escribe)
+};
+
+constexpr size_t NUM_SYNTHETIC_PATTERNS = 6;
+
+const char* synthetic_pattern_name(SyntheticPattern pattern);
+
+struct SyntheticConfig {
+    SyntheticPattern pattern = SyntheticPattern::READ_MOSTLY;
+    int num_pes = 4;
+    size_t ops_per_pe = 10000;                                                          // Registros por PE
+    size_t address_range = 1024;                                                        // Palabras usadas por región (se recorta a 16 bits)
+    double write_ratio = 0.1;                                                           // Donde el patrón admite mezcla
+    uint32_t think_ns = 0;
+    uint64_t seed = 1;
+};
+
+// Los flujos generados son deterministas para una misma configuración
+vector<WorkloadStreamBuilder> generate_synthetic(const SyntheticConfig& config);
+bool make_synthetic_trace(const SyntheticConfig& config, WorkloadTrace& trace);
+
+#endif // SYNTHETIC_H
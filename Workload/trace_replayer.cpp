@@ -0,0 +1,85 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "trace_replayer.h"
+#include "../MESI/MESIController.h"
+
+using namespace std;
+
+TraceReplayer::TraceReplayer(const WorkloadTrace& trace, const vector<MESIController*>& controllers, bool non_blocking)
+    : trace_(trace), controllers_(controllers), non_blocking_(non_blocking) {}
+
+
+ReplayResult TraceReplayer::run() {
+    vector<const WorkloadStream*> runnable;
+    for (const auto& stream : trace_.streams()) {
+        if (stream.pe_id >= 0 && stream.pe_id < static_cast<int>(controllers_.size()) && controllers_[stream.pe_id]) {
+            runnable.push_back(&stream);
+        } else {
+            cerr << "[Workload] Flujo del PE " << stream.pe_id << " sin controlador, se ignora" << endl;
+        }
+    }
+
+    struct alignas(64) Counters {                                                       // Uno por hilo, sin compartir líneas
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+    };
+    vector<Counters> counters(runnable.size());
+
+    atomic<size_t> ready{0};                                                            // Todos los PEs arrancan juntos
+    atomic<bool> go{false};
+    vector<thread> threads;
+    threads.reserve(runnable.size());
+
+    for (size_t t = 0; t < runnable.size(); ++t) {
+        threads.emplace_back([&, t] {
+            const WorkloadStream& stream = *runnable[t];
+            MESIController* mesi = controllers_[stream.pe_id];
+            Counters& local = counters[t];
+
+            ready.fetch_add(1, memory_order_release);
+            while (!go.load(memory_order_acquire)) this_thread::yield();
+
+            for (const WorkloadRecord& record : stream) {
+                if (record.think_ns) think(record.think_ns);
+                if (record.op == WorkloadOp::WRITE) {
+                    if (non_blocking_) mesi->write_async(record.address, record.value);
+                    else mesi->write(record.address, record.value);
+                    local.writes++;
+                } else {
+                    if (non_blocking_) mesi->read_async(record.address);
+                    else mesi->read(record.address);
+                    local.reads++;
+                }
+            }
+            mesi->drain();
+        });
+    }
+
+    while (ready.load(memory_order_acquire) < runnable.size()) this_thread::yield();
+    auto start = chrono::steady_clock::now();
+    go.store(true, memory_order_release);
+    for (auto& t : threads) t.join();
+
+    ReplayResult result;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    for (const auto& c : counters) {
+        result.reads += c.reads;
+        result.writes += c.writes;
+    }
+    result.operations = result.reads + result.writes;
+    return result;
+}
+
+
+// Pausas cortas con espera activa (sleep no tiene resolución de ns); las largas ceden el núcleo
+void TraceReplayer::think(uint32_t think_ns) {
+    auto until = chrono::steady_clock::now() + chrono::nanoseconds(think_ns);
+    if (think_ns >= 100000) {
+        this_thread::sleep_until(until);
+        return;
+    }
+    while (chrono::steady_clock::now() < until) this_thread::yield();
+}
@@ -0,0 +1,45 @@
+#ifndef TRACE_REPLAYER_H
+#define TRACE_REPLAYER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "workload_trace.h"
+
+using namespace std;
+
+class MESIController;
+
+// Resultado de una reproducción: accesos hechos y tiempo total (desde que todos los PEs arrancan)
+struct ReplayResult {
+    uint64_t operations = 0;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    double seconds = 0.0;
+
+    double operations_per_second() const { return seconds > 0.0 ? operations / seconds : 0.0; }
+};
+
+
+// Reproduce una WorkloadTrace sobre los controladores de coherencia: un hilo por flujo, que recorre
+// los registros en sitio (sin reservar memoria por acceso) y llama a read/write de su PE.
+// La misma carga puede reproducirse sobre distintas configuraciones de protocolo y bus.
+// Con non_blocking cada hilo usa read_async/write_async: sigue con el próximo registro mientras sus
+// misses están en vuelo y solo espera si se queda sin MSHRs (ver MESIController).
+class TraceReplayer {
+public:
+    // controllers[pe_id] atiende el flujo de ese PE; los flujos sin controlador se ignoran
+    TraceReplayer(const WorkloadTrace& trace, const vector<MESIController*>& controllers, bool non_blocking = false);
+
+    ReplayResult run();
+
+private:
+    const WorkloadTrace& trace_;
+    vector<MESIController*> controllers_;
+    bool non_blocking_;
+
+    static void think(uint32_t think_ns);
+};
+
+#endif // TRACE_REPLAYER_H
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "workload_trace.h"
+
+using namespace std;
+
+// ==================================================================================== LECTURA ===
+
+
+WorkloadTrace::~WorkloadTrace() {
+    close();
+}
+
+
+WorkloadTrace::WorkloadTrace(WorkloadTrace&& other) noexcept {
+    *this = move(other);
+}
+
+
+WorkloadTrace& WorkloadTrace::operator=(WorkloadTrace&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        mapped_ = other.mapped_;
+        buffer_ = move(other.buffer_);                                                  // El bloque del vector no cambia de dirección
+        streams_ = move(other.streams_);
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_ = false;
+        other.streams_.clear();
+    }
+    return *this;
+}
+
+
+// Mapea el archivo completo en solo lectura; los registros se leen en sitio desde el mapeo
+bool WorkloadTrace::open(const string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "[Workload] No se pudo abrir " << path << endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(WorkloadHeader))) {
+        cerr << "[Workload] Archivo de carga vacío o ilegible: " << path << endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* addr = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);                                                                        // El mapeo sigue válido sin el descriptor
+    if (addr == MAP_FAILED) {
+        cerr << "[Workload] mmap falló para " << path << endl;
+        return false;
+    }
+    madvise(addr, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);                  // Cada PE recorre su flujo en orden
+
+    data_ = static_cast<const uint8_t*>(addr);
+    size_ = static_cast<size_t>(info.st_size);
+    mapped_ = true;
+
+    if (!parse()) {
+        cerr << "[Workload] Formato inválido en " << path << endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+
+bool WorkloadTrace::from_buffer(vector<uint8_t> buffer) {
+    close();
+    buffer_ = move(buffer);
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+
+    if (size_ < sizeof(WorkloadHeader) || !parse()) {
+        cerr << "[Workload] Buffer de carga inválido" << endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+
+void WorkloadTrace::close() {
+    if (mapped_ && data_) munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+    streams_.clear();
+}
+
+
+size_t WorkloadTrace::total_records() const {
+    size_t total = 0;
+    for (const auto& stream : streams_) total += stream.count;
+    return total;
+}
+
+
+void WorkloadTrace::drop_front(size_t n) {
+    for (auto& stream : streams_) {
+        size_t skip = min(n, stream.count);
+        stream.records += skip;
+        stream.count -= skip;
+    }
+}
+
+
+// Valida encabezado y tabla de flujos; cada flujo debe caer completo y alineado dentro de los datos.
+// Un pe_id repetido se rechaza: el reproductor lanza un hilo por flujo y dos hilos sobre el mismo
+// MESIController serían una carrera de datos.
+bool WorkloadTrace::parse() {
+    WorkloadHeader header;
+    memcpy(&header, data_, sizeof(header));
+    if (memcmp(header.magic, kWorkloadMagic, sizeof(kWorkloadMagic)) != 0) return false;
+    if (header.record_size != sizeof(WorkloadRecord)) return false;
+
+    size_t table_end = sizeof(WorkloadHeader) + static_cast<size_t>(header.num_streams) * sizeof(WorkloadStreamEntry);
+    if (table_end > size_) return false;
+
+    streams_.clear();
+    streams_.reserve(header.num_streams);
+    for (uint32_t i = 0; i < header.num_streams; ++i) {
+        WorkloadStreamEntry entry;
+        memcpy(&entry, data_ + sizeof(WorkloadHeader) + i * sizeof(WorkloadStreamEntry), sizeof(entry));
+
+        if (entry.offset % alignof(WorkloadRecord) != 0 || entry.offset > size_) return false;
+        if (entry.count > (size_ - entry.offset) / sizeof(WorkloadRecord)) return false;
+
+        for (const auto& previous : streams_) {
+            if (previous.pe_id == entry.pe_id) {
+                cerr << "[Workload] Flujo repetido para el PE " << entry.pe_id << endl;
+                return false;
+            }
+        }
+
+        WorkloadStream stream;
+        stream.pe_id = entry.pe_id;
+        stream.records = reinterpret_cast<const WorkloadRecord*>(data_ + entry.offset);
+        stream.count = static_cast<size_t>(entry.count);
+        streams_.push_back(stream);
+    }
+    return true;
+}
+
+
+// ==================================================================================== ESCRITURA ===
+
+
+vector<uint8_t> encode_workload(const vector<WorkloadStreamBuilder>& streams) {
+    size_t table_end = sizeof(WorkloadHeader) + streams.size() * sizeof(WorkloadStreamEntry);
+    size_t offset = (table_end + alignof(WorkloadRecord) - 1) / alignof(WorkloadRecord) * alignof(WorkloadRecord);
+
+    size_t total = offset;
+    for (const auto& stream : streams) total += stream.records.size() * sizeof(WorkloadRecord);
+    vector<uint8_t> out(total, 0);
+
+    WorkloadHeader header;
+    memcpy(header.magic, kWorkloadMagic, sizeof(kWorkloadMagic));
+    header.record_size = sizeof(WorkloadRecord);
+    header.num_streams = static_cast<uint32_t>(streams.size());
+    memcpy(out.data(), &header, sizeof(header));
+
+    for (size_t i = 0; i < streams.size(); ++i) {
+        WorkloadStreamEntry entry{};
+        entry.pe_id = streams[i].pe_id;
+        entry.offset = offset;
+        entry.count = streams[i].records.size();
+        memcpy(out.data() + sizeof(WorkloadHeader) + i * sizeof(WorkloadStreamEntry), &entry, sizeof(entry));
+
+        size_t bytes = streams[i].records.size() * sizeof(WorkloadRecord);
+        if (bytes) memcpy(out.data() + offset, streams[i].records.data(), bytes);
+        offset += bytes;
+    }
+    return out;
+}
+
+
+bool write_workload(const string& path, const vector<WorkloadStreamBuilder>& streams) {
+    ofstream out(path, ios::binary);
+    if (!out) {
+        cerr << "[Workload] No se pudo abrir " << path << endl;
+        return false;
+    }
+    vector<uint8_t> data = encode_workload(streams);
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<streamsize>(data.size()));
+    return static_cast<bool>(out);
+}
+
+
+// ==================================================================================== FORMATO DE TEXTO ===
+
+
+bool parse_text_workload(istream& in, vector<WorkloadStreamBuilder>& streams) {
+    string line;
+    size_t line_number = 0;
+
+    while (getline(in, line)) {
+        line_number++;
+        size_t comment = line.find('#');
+        if (comment != string::npos) line.erase(comment);
+
+        istringstream fields(line);
+        int pe_id;
+        string op;
+        if (!(fields >> pe_id)) continue;                                               // Línea vacía o solo comentario
+
+        WorkloadRecord record{};
+        unsigned long address = 0;
+        unsigned long think_ns = 0;
+        if (!(fields >> op >> address) || pe_id < 0 || address > 0xFFFF) {
+            cerr << "[Workload] Línea " << line_number << " inválida: " << line << endl;
+            return false;
+        }
+
+        if (op == "R" || op == "r") {
+            record.op = WorkloadOp::READ;
+        } else if (op == "W" || op == "w") {
+            record.op = WorkloadOp::WRITE;
+            if (!(fields >> record.value)) {
+                cerr << "[Workload] Línea " << line_number << ": W requiere un valor" << endl;
+                return false;
+            }
+        } else {
+            cerr << "[Workload] Línea " << line_number << ": operación desconocida " << op << endl;
+            return false;
+        }
+        fields >> think_ns;
+
+        record.address = static_cast<uint16_t>(address);
+        record.think_ns = static_cast<uint32_t>(think_ns);
+
+        WorkloadStreamBuilder* target = nullptr;                                        // Un flujo por PE, en orden de aparición
+        for (auto& stream : streams) {
+            if (stream.pe_id == pe_id) target = &stream;
+        }
+        if (!target) {
+            streams.push_back(WorkloadStreamBuilder{pe_id, {}});
+            target = &streams.back();
+        }
+        target->records.push_back(record);
+    }
+    return true;
+}
+
+
+bool import_text_workload(const string& text_path, WorkloadTrace& trace) {
+    ifstream in(text_path);
+    if (!in) {
+        cerr << "[Workload] No se pudo abrir " << text_path << endl;
+        return false;
+    }
+    vector<WorkloadStreamBuilder> streams;
+    if (!parse_text_workload(in, streams)) return false;
+    return trace.from_buffer(encode_workload(streams));
+}
+
+
+bool convert_text_workload(const string& text_path, const string& binary_path) {
+    ifstream in(text_path);
+    if (!in) {
+        cerr << "[Workload] No se pudo abrir " << text_path << endl;
+        return false;
+    }
+    vector<WorkloadStreamBuilder> streams;
+    if (!parse_text_workload(in, streams)) return false;
+    return write_workload(binary_path, streams);
+}
@@ -0,0 +1,119 @@
+#ifndef WORKLOAD_TRACE_H
+#define WORKLOAD_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ==================================================================================== FORMATO BINARIO ===
+
+// Archivo de carga de trabajo: encabezado, tabla de flujos (uno por PE; un pe_id repetido invalida el
+// archivo) y los registros de cada flujo contiguos. Se lee con mmap y los PEs recorren sus registros en sitio, sin copiar ni reservar memoria.
+//
+//   WorkloadHeader | WorkloadStreamEntry[num_streams] | WorkloadRecord[...] (flujo 0, flujo 1, ...)
+
+enum class WorkloadOp : uint8_t {
+    READ,
+    WRITE,
+};
+
+struct WorkloadRecord {
+    uint16_t address;
+    WorkloadOp op;
+    uint8_t reserved;
+    uint32_t think_ns;                                                                  // Pausa del PE antes del acceso
+    double value;                                                                       // Dato a escribir (WRITE)
+};
+
+static_assert(sizeof(WorkloadRecord) == 16, "WorkloadRecord debe mantener el formato binario de 16 bytes");
+
+constexpr char kWorkloadMagic[8] = {'M', 'P', 'W', 'K', 'L', 'D', '0', '1'};
+
+struct WorkloadHeader {
+    char magic[8];
+    uint32_t record_size;
+    uint32_t num_streams;
+};
+
+struct WorkloadStreamEntry {
+    int32_t pe_id;
+    uint32_t reserved;
+    uint64_t offset;                                                                    // Bytes desde el inicio del archivo
+    uint64_t count;                                                                     // Cantidad de registros
+};
+
+static_assert(sizeof(WorkloadHeader) == 16 && sizeof(WorkloadStreamEntry) == 24, "Formato de encabezado de carga");
+
+
+// Vista de solo lectura de los registros de un PE
+struct WorkloadStream {
+    int pe_id = -1;
+    const WorkloadRecord* records = nullptr;
+    size_t count = 0;
+
+    const WorkloadRecord* begin() const { return records; }
+    const WorkloadRecord* end() const { return records + count; }
+};
+
+
+// ==================================================================================== CARGA DE TRABAJO ===
+
+// Carga de trabajo lista para reproducir. Se obtiene mapeando un archivo binario (open) o desde un
+// buffer en memoria (from_buffer, usado por el importador de texto). No se puede copiar; sí mover.
+class WorkloadTrace {
+public:
+    WorkloadTrace() = default;
+    ~WorkloadTrace();
+
+    WorkloadTrace(const WorkloadTrace&) = delete;
+    WorkloadTrace& operator=(const WorkloadTrace&) = delete;
+    WorkloadTrace(WorkloadTrace&& other) noexcept;
+    WorkloadTrace& operator=(WorkloadTrace&& other) noexcept;
+
+    bool open(const string& path);                                                      // mmap de solo lectura
+    bool from_buffer(vector<uint8_t> buffer);
+    void close();
+
+    bool is_open() const { return data_ != nullptr; }
+    size_t num_streams() const { return streams_.size(); }
+    const WorkloadStream& stream(size_t i) const { return streams_[i]; }
+    const vector<WorkloadStream>& streams() const { return streams_; }
+    size_t total_records() const;
+
+    // Descarta los primeros n registros de cada flujo (ya reproducidos, p. ej. en fast-forward)
+    void drop_front(size_t n);
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;                                                               // true: munmap al cerrar
+    vector<uint8_t> buffer_;                                                            // Dueño de los datos si no es mmap
+    vector<WorkloadStream> streams_;
+
+    bool parse();
+};
+
+
+// ==================================================================================== ESCRITURA E IMPORTACIÓN ===
+
+// Registros de un PE al construir una carga (generadores, importador de texto)
+struct WorkloadStreamBuilder {
+    int pe_id;
+    vector<WorkloadRecord> records;
+};
+
+vector<uint8_t> encode_workload(const vector<WorkloadStreamBuilder>& streams);
+bool write_workload(const string& path, const vector<WorkloadStreamBuilder>& streams);
+
+// Formato de texto para pruebas a mano, una operación por línea ('#' inicia comentario):
+//   <pe> R <dirección> [think_ns]
+//   <pe> W <dirección> <valor> [think_ns]
+bool parse_text_workload(istream& in, vector<WorkloadStreamBuilder>& streams);
+bool import_text_workload(const string& text_path, WorkloadTrace& trace);
+bool convert_text_workload(const string& text_path, const string& binary_path);
+
+#endif // WORKLOAD_TRACE_H